@@ -3,6 +3,7 @@
 #include <string.h>
 
 #define TAM 50
+#define ALTURA_MAX 64 // Limite folgado para a altura de uma AVL (mais de 2^44 nós)
 
 // ------------------------------
 // Estruturas de dados
@@ -16,6 +17,7 @@ typedef struct Sala {
 
 typedef struct PistaNode {
     char pista[TAM];
+    int altura; // Altura da subárvore (folha = 1)
     struct PistaNode *esquerda;
     struct PistaNode *direita;
 } PistaNode;
@@ -37,35 +39,135 @@ Sala* criarSala(char nome[], char pista[]) {
     return nova;
 }
 
+// Libera todas as salas sem recursão nem pilha: enquanto houver filho à
+// esquerda, uma rotação à direita o sobe; sem ele, a sala é liberada e o
+// percurso segue pela direita (O(n) passos no total)
+void liberarMansao(Sala *raiz) {
+    while (raiz != NULL) {
+        if (raiz->esquerda != NULL) {
+            Sala *filho = raiz->esquerda;
+            raiz->esquerda = filho->direita;
+            filho->direita = raiz;
+            raiz = filho;
+        } else {
+            Sala *proxima = raiz->direita;
+            free(raiz);
+            raiz = proxima;
+        }
+    }
+}
+
 // ------------------------------
 // Funções relacionadas às pistas (BST)
 // ------------------------------
 
-// Insere uma nova pista em ordem alfabética na árvore BST
+int altura(PistaNode *no) {
+    return no ? no->altura : 0;
+}
+
+void atualizarAltura(PistaNode *no) {
+    int he = altura(no->esquerda), hd = altura(no->direita);
+    no->altura = 1 + (he > hd ? he : hd);
+}
+
+PistaNode* rotacaoDireita(PistaNode *no) {
+    PistaNode *filho = no->esquerda;
+    no->esquerda = filho->direita;
+    filho->direita = no;
+    atualizarAltura(no);
+    atualizarAltura(filho);
+    return filho;
+}
+
+PistaNode* rotacaoEsquerda(PistaNode *no) {
+    PistaNode *filho = no->direita;
+    no->direita = filho->esquerda;
+    filho->esquerda = no;
+    atualizarAltura(no);
+    atualizarAltura(filho);
+    return filho;
+}
+
+// Rebalanceia um nó (AVL) e retorna a nova raiz da subárvore
+PistaNode* balancear(PistaNode *no) {
+    atualizarAltura(no);
+    int fator = altura(no->esquerda) - altura(no->direita);
+    if (fator > 1) {
+        if (altura(no->esquerda->esquerda) < altura(no->esquerda->direita))
+            no->esquerda = rotacaoEsquerda(no->esquerda);
+        return rotacaoDireita(no);
+    }
+    if (fator < -1) {
+        if (altura(no->direita->direita) < altura(no->direita->esquerda))
+            no->direita = rotacaoDireita(no->direita);
+        return rotacaoEsquerda(no);
+    }
+    return no;
+}
+
+// Insere uma nova pista em ordem alfabética na árvore AVL.
+// A descida é iterativa; só o caminho percorrido é rebalanceado na volta.
 PistaNode* inserirPista(PistaNode *raiz, char pista[]) {
     if (strlen(pista) == 0) return raiz; // ignora cômodos sem pista
 
-    if (raiz == NULL) {
-        PistaNode *novo = (PistaNode*) malloc(sizeof(PistaNode));
-        strcpy(novo->pista, pista);
-        novo->esquerda = novo->direita = NULL;
-        return novo;
+    PistaNode **caminho[ALTURA_MAX];
+    int n = 0;
+    PistaNode **ligacao = &raiz;
+
+    while (*ligacao != NULL) {
+        int cmp = strcmp(pista, (*ligacao)->pista);
+        if (cmp == 0) return raiz; // pista repetida
+        caminho[n++] = ligacao;
+        ligacao = (cmp < 0) ? &(*ligacao)->esquerda : &(*ligacao)->direita;
     }
 
-    if (strcmp(pista, raiz->pista) < 0)
-        raiz->esquerda = inserirPista(raiz->esquerda, pista);
-    else if (strcmp(pista, raiz->pista) > 0)
-        raiz->direita = inserirPista(raiz->direita, pista);
+    PistaNode *novo = (PistaNode*) malloc(sizeof(PistaNode));
+    strcpy(novo->pista, pista);
+    novo->altura = 1;
+    novo->esquerda = novo->direita = NULL;
+    *ligacao = novo;
+
+    while (n > 0) {
+        PistaNode **anc = caminho[--n];
+        int antes = (*anc)->altura;
+        *anc = balancear(*anc);
+        if ((*anc)->altura == antes) break;
+    }
 
     return raiz;
 }
 
-// Exibe as pistas coletadas em ordem alfabética
+// Exibe as pistas coletadas em ordem alfabética (percurso em ordem com pilha
+// explícita; a AVL nunca passa de ALTURA_MAX níveis)
 void exibirPistas(PistaNode *raiz) {
-    if (raiz != NULL) {
-        exibirPistas(raiz->esquerda);
-        printf("🔎 %s\n", raiz->pista);
-        exibirPistas(raiz->direita);
+    PistaNode *pilha[ALTURA_MAX];
+    int topo = 0;
+    PistaNode *atual = raiz;
+
+    while (atual != NULL || topo > 0) {
+        while (atual != NULL) {
+            pilha[topo++] = atual;
+            atual = atual->esquerda;
+        }
+        atual = pilha[--topo];
+        printf("🔎 %s\n", atual->pista);
+        atual = atual->direita;
+    }
+}
+
+// Libera a árvore de pistas com a mesma técnica de liberarMansao
+void liberarPistas(PistaNode *raiz) {
+    while (raiz != NULL) {
+        if (raiz->esquerda != NULL) {
+            PistaNode *filho = raiz->esquerda;
+            raiz->esquerda = filho->direita;
+            filho->direita = raiz;
+            raiz = filho;
+        } else {
+            PistaNode *proxima = raiz->direita;
+            free(raiz);
+            raiz = proxima;
+        }
     }
 }
 
@@ -136,6 +238,9 @@ int main() {
     else
         printf("Nenhuma pista foi coletada!\n");
 
+    liberarPistas(pistas);
+    liberarMansao(hall);
+
     printf("\nFim da exploração.\n");
     return 0;
 }
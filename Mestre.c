@@ -1,400 +1,241 @@
+// Detective Quest - Nível Mestre: a linha de comando do jogo.
+// O motor (mansão, pistas, associações e veredito) fica em libdetective (detective.h).
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h> // Para tolower
-
-// Constantes
-#define TAMANHO_MAX_STRING 50
-#define TAMANHO_TABELA_HASH 10 // Um tamanho pequeno para simplificar
-
-// --- 1. ESTRUTURAS DE DADOS ---
-
-// Estrutura para o Nó da Árvore Binária (Mansão)
-typedef struct NoSala {
-    char nome[TAMANHO_MAX_STRING];
-    char pista[TAMANHO_MAX_STRING]; // Pista estática associada à sala
-    struct NoSala *esquerda;
-    struct NoSala *direita;
-} NoSala;
-
-// Estrutura para o Nó da Árvore de Busca Binária (Pistas Coletadas)
-typedef struct NoPista {
-    char pista[TAMANHO_MAX_STRING];
-    struct NoPista *esquerda;
-    struct NoPista *direita;
-} NoPista;
-
-// Estrutura para um Item da Tabela Hash (Associação Pista -> Suspeito)
-typedef struct HashItem {
-    char pista[TAMANHO_MAX_STRING];
-    char suspeito[TAMANHO_MAX_STRING];
-    struct HashItem *proximo; // Para tratamento de colisão (encadeamento)
-} HashItem;
-
-// Estrutura para a Tabela Hash
-typedef struct TabelaHash {
-    HashItem *itens[TAMANHO_TABELA_HASH];
-} TabelaHash;
-
-
-// --- 2. FUNÇÕES DE SUPORTE ---
-
-/**
- *  Criar dinamicamente um novo cômodo (nó de sala) na mansão.
- *  O nome exclusivo do cômodo.
- *  A pista estática associada a este cômodo.
- *  Um ponteiro para a nova estrutura NoSala alocada.
- */
-NoSala* criarSala(const char *nome, const char *pista) {
-    NoSala *novaSala = (NoSala*)malloc(sizeof(NoSala));
-    if (novaSala == NULL) {
-        perror("Erro de alocação de memória para NoSala");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(novaSala->nome, nome, TAMANHO_MAX_STRING - 1);
-    novaSala->nome[TAMANHO_MAX_STRING - 1] = '\0';
-    strncpy(novaSala->pista, pista, TAMANHO_MAX_STRING - 1);
-    novaSala->pista[TAMANHO_MAX_STRING - 1] = '\0';
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
-    printf("> Cômodo '%s' (Pista: '%s') criado.\n", nome, pista);
-    return novaSala;
-}
-
-/**
- * Inserir a pista coletada na Árvore de Busca Binária (BST) de forma ordenada.
- * O nó raiz da BST de pistas.
- * A string da pista a ser inserida.
- * O novo nó raiz (ou o nó existente) da BST de pistas.
- */
-NoPista* inserirPista(NoPista *raiz, const char *novaPista) {
-    if (raiz == NULL) {
-        NoPista *novoNo = (NoPista*)malloc(sizeof(NoPista));
-        if (novoNo == NULL) {
-            perror("Erro de alocação de memória para NoPista");
-            exit(EXIT_FAILURE);
-        }
-        strncpy(novoNo->pista, novaPista, TAMANHO_MAX_STRING - 1);
-        novoNo->pista[TAMANHO_MAX_STRING - 1] = '\0';
-        novoNo->esquerda = NULL;
-        novoNo->direita = NULL;
-        return novoNo;
-    }
-
-    int comparacao = strcmp(novaPista, raiz->pista);
-
-    if (comparacao < 0) {
-        raiz->esquerda = inserirPista(raiz->esquerda, novaPista);
-    } else if (comparacao > 0) {
-        raiz->direita = inserirPista(raiz->direita, novaPista);
-    }
-    // Ignora se a pista já existe (comparacao == 0)
-
-    return raiz;
-}
-
-// Função de hash simples para strings
-unsigned int hash(const char *chave) {
-    unsigned int hashVal = 0;
-    for (int i = 0; chave[i] != '\0'; i++) {
-        hashVal = hashVal * 31 + chave[i];
-    }
-    return hashVal % TAMANHO_TABELA_HASH;
+#include <unistd.h> // Para sysconf
+
+#include "detective.h"
+
+// --- FUNÇÃO PRINCIPAL (MAIN) ---
+
+// Mostra as opções de linha de comando
+void mostrarUso(const char *programa) {
+    fprintf(stderr, "Uso: %s [--caso arquivo] [--roteiro arquivo|-] [--verboso]\n", programa);
+    fprintf(stderr, "     %s --converter entrada saida.dqc\n", programa);
+    fprintf(stderr, "     %s --gerar-mphf caso saida.dqm\n", programa);
+    fprintf(stderr, "  --caso arquivo          carrega a mansão e as associações de um arquivo (texto ou .dqc)\n");
+    fprintf(stderr, "  --converter ent sai     converte um caso (texto ou binário) para o formato binário\n");
+    fprintf(stderr, "  --gerar-mphf caso sai   gera o hash perfeito mínimo das associações do caso (.dqm)\n");
+    fprintf(stderr, "  --mphf arquivo.dqm      consulta as associações do caso pelo hash perfeito gerado antes\n");
+    fprintf(stderr, "  --filtro taxa           filtro de Bloom na frente das associações, com essa taxa de\n");
+    fprintf(stderr, "                          falsos positivos (ex.: 0.01); os contadores aparecem em --stats\n");
+    fprintf(stderr, "  --roteiro arquivo|-     reproduz sessões sem interação (um comando por linha; '-' = stdin)\n");
+    fprintf(stderr, "                          e imprime só uma linha VEREDITO por sessão\n");
+    fprintf(stderr, "  --verboso               no modo roteiro, narra também cada sessão (= --log info)\n");
+    fprintf(stderr, "  --sessao arquivo        no jogo interativo, retoma a investigação guardada no arquivo (se houver);\n");
+    fprintf(stderr, "                          'p' ou o fim da entrada antes da acusação a guardam de novo\n");
+    fprintf(stderr, "  --servidor socket       atende roteiros em paralelo num socket Unix (uma conexão = um roteiro)\n");
+    fprintf(stderr, "  --varredura             visita todas as salas, conta as evidências em paralelo e confere\n");
+    fprintf(stderr, "                          o resultado com a contagem sequencial\n");
+    fprintf(stderr, "  --trabalhadores n       threads do servidor e da varredura (padrão: um por núcleo)\n");
+    fprintf(stderr, "  --log nível             silencioso, info ou depuracao (cada sala e associação criada)\n");
+    fprintf(stderr, "  --hash nome             função de hash: rapido (padrão), fnv1a ou polinomial\n");
+    fprintf(stderr, "  --relatorio-hash        mostra a distribuição das tabelas hash do caso e sai\n");
+    fprintf(stderr, "  --stats                 ao final, mostra em stderr as estatísticas das estruturas\n");
+    fprintf(stderr, "  --tempos                mede as fases e mostra em stderr p50/p99/máximo de cada uma\n");
+    fprintf(stderr, "  --trace arquivo.json    como --tempos, e grava um trace do Chrome/Perfetto\n");
 }
 
-/**
- * Insere a associação pista/suspeito na Tabela Hash.
- * Resolve colisões usando encadeamento.
- *  Tabela, O ponteiro para a TabelaHash.
- *  A pista (chave) a ser associada.
- *  O suspeito (valor) correspondente à pista.
- */
-void inserirNaHash(TabelaHash *tabela, const char *pista, const char *suspeito) {
-    unsigned int indice = hash(pista);
-
-    // Cria o novo item
-    HashItem *novoItem = (HashItem*)malloc(sizeof(HashItem));
-    if (novoItem == NULL) {
-        perror("Erro de alocação de memória para HashItem");
-        exit(EXIT_FAILURE);
-    }
-    strncpy(novoItem->pista, pista, TAMANHO_MAX_STRING - 1);
-    novoItem->pista[TAMANHO_MAX_STRING - 1] = '\0';
-    strncpy(novoItem->suspeito, suspeito, TAMANHO_MAX_STRING - 1);
-    novoItem->suspeito[TAMANHO_MAX_STRING - 1] = '\0';
-    novoItem->proximo = NULL;
-
-    // Inserção no início da lista encadeada (ou substitui se já existir)
-    HashItem *atual = tabela->itens[indice];
-    HashItem *anterior = NULL;
-
-    while (atual != NULL) {
-        if (strcmp(atual->pista, pista) == 0) {
-            // Se a chave já existe, apenas atualiza o valor
-            strncpy(atual->suspeito, suspeito, TAMANHO_MAX_STRING - 1);
-            atual->suspeito[TAMANHO_MAX_STRING - 1] = '\0';
-            free(novoItem); // Libera o item recém-criado, pois não será usado
-            return;
-        }
-        anterior = atual;
-        atual = atual->proximo;
-    }
-    
-    // Insere o novo item no início da lista no índice
-    novoItem->proximo = tabela->itens[indice];
-    tabela->itens[indice] = novoItem;
-
-    printf("> Associação na Hash: Pista '%s' -> Suspeito '%s' inserida no índice %u.\n", pista, suspeito, indice);
-}
-
-/**
- * Consulta o suspeito correspondente a uma pista na Tabela Hash.
- * Tabela, O ponteiro para a TabelaHash.
- * A pista (chave) a ser procurada.
- * O ponteiro para a string do nome do suspeito, ou NULL se não for encontrada.
- */
-const char* encontrarSuspeito(TabelaHash *tabela, const char *pista) {
-    unsigned int indice = hash(pista);
-    HashItem *atual = tabela->itens[indice];
-
-    while (atual != NULL) {
-        if (strcmp(atual->pista, pista) == 0) {
-            return atual->suspeito;
-        }
-        atual = atual->proximo;
-    }
-    return NULL; // Pista não encontrada na hash
-}
-
-// --- 3. FUNÇÕES DO JOGO ---
-
-/**
- * Função recursiva principal para navegação e interação do jogador na mansão.
- * O nó da sala atual na Árvore Binária da mansão.
- * A raiz da BST onde as pistas encontradas serão armazenadas.
- * O ponteiro para a Tabela Hash de associações Pista/Suspeito.
- * A raiz da BST de pistas atualizada.
- */
-NoPista* explorarSalas(NoSala *atual, NoPista *pistasColetadas, TabelaHash *tabelaHash) {
-    char acao[10];
-
-    while (atual != NULL) {
-        printf("\n--- Você está no cômodo: **%s** ---\n", atual->nome);
-
-        // 1. Coleta da Pista
-        if (atual->pista[0] != '\0') {
-            printf(" Você encontrou uma pista: **%s**\n", atual->pista);
-            
-            // Insere na BST (Árvore de Pistas)
-            NoPista* raizAnterior = pistasColetadas;
-            pistasColetadas = inserirPista(pistasColetadas, atual->pista);
-            
-            if (raizAnterior != pistasColetadas && raizAnterior != NULL) {
-                // A inserção real (não duplicada) ocorreu
-                printf(" Pista coletada e registrada.\n");
-            } else if (raizAnterior == pistasColetadas && raizAnterior != NULL && strcmp(atual->pista, atual->nome) != 0) {
-                // Se a BST não mudou e não é a raiz, a pista já havia sido coletada
-                printf(" Pista já havia sido coletada.\n");
+int main(int argc, char *argv[]) {
+    const char *arquivoCaso = NULL;
+    const char *arquivoRoteiro = NULL;
+    int verboso = 0;
+    int mostrarRelatorio = 0;
+    int mostrarEstatisticas = 0;
+    int mostrarTempos = 0;
+    const char *arquivoTrace = NULL;
+    int nivel = -1; // -1 = padrão do modo escolhido
+    const char *socketServidor = NULL;
+    int varredura = 0;
+    const char *arquivoSessao = NULL;
+    const char *arquivoPerfeita = NULL;
+    double taxaFiltro = 0.0; // 0 = sem filtro de Bloom
+    long trabalhadores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (trabalhadores < 1) trabalhadores = 1; // sysconf pode falhar (-1)
+    if (trabalhadores > MAXIMO_TRABALHADORES) trabalhadores = MAXIMO_TRABALHADORES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--caso") == 0 && i + 1 < argc) {
+            arquivoCaso = argv[++i];
+        } else if (strcmp(argv[i], "--roteiro") == 0 && i + 1 < argc) {
+            arquivoRoteiro = argv[++i];
+        } else if (strcmp(argv[i], "--verboso") == 0) {
+            verboso = 1;
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            nivel = nivelDoNome(argv[++i]);
+            if (nivel < 0) {
+                fprintf(stderr, "Nível de log desconhecido: %s\n", argv[i]);
+                return EXIT_FAILURE;
             }
-        } else {
-            printf("O cômodo parece estar limpo. Nenhuma pista visível aqui.\n");
-        }
-
-        // 2. Escolha de Navegação
-        printf("\nPara onde deseja ir? **(e)**squerda, **(d)**ireita ou **(s)**air da exploração: ");
-        if (scanf("%s", acao) != 1) {
-             // Limpa o buffer de entrada em caso de erro
-             while (getchar() != '\n'); 
-             continue; // Tenta novamente
-        }
-
-        // Limpa o buffer de entrada
-        while (getchar() != '\n'); 
-
-        char escolha = tolower(acao[0]);
-
-        if (escolha == 's') {
-            printf("\nFim da exploração. Preparando para a fase de julgamento...\n");
-            return pistasColetadas;
-        } else if (escolha == 'e') {
-            if (atual->esquerda != NULL) {
-                atual = atual->esquerda;
-            } else {
-                printf(" Não há saída para a esquerda neste cômodo. Tente outra direção.\n");
+        } else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            if (!selecionarHash(argv[++i])) {
+                fprintf(stderr, "Função de hash desconhecida: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--servidor") == 0 && i + 1 < argc) {
+            socketServidor = argv[++i];
+        } else if (strcmp(argv[i], "--filtro") == 0 && i + 1 < argc) {
+            taxaFiltro = strtod(argv[++i], NULL);
+            if (!(taxaFiltro > 0.0 && taxaFiltro < 1.0)) {
+                fprintf(stderr, "A taxa de falsos positivos do filtro deve estar entre 0 e 1.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--mphf") == 0 && i + 1 < argc) {
+            arquivoPerfeita = argv[++i];
+        } else if (strcmp(argv[i], "--sessao") == 0 && i + 1 < argc) {
+            arquivoSessao = argv[++i];
+        } else if (strcmp(argv[i], "--varredura") == 0) {
+            varredura = 1;
+        } else if (strcmp(argv[i], "--trabalhadores") == 0 && i + 1 < argc) {
+            trabalhadores = strtol(argv[++i], NULL, 10);
+            if (trabalhadores < 1 || trabalhadores > MAXIMO_TRABALHADORES) {
+                fprintf(stderr, "Número de trabalhadores deve estar entre 1 e %d.\n", MAXIMO_TRABALHADORES);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--tempos") == 0) {
+            mostrarTempos = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            arquivoTrace = argv[++i];
+            mostrarTempos = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            mostrarEstatisticas = 1;
+        } else if (strcmp(argv[i], "--relatorio-hash") == 0) {
+            mostrarRelatorio = 1;
+        } else if (strcmp(argv[i], "--converter") == 0 && i + 2 < argc) {
+            Caso *conversao = criarCaso();
+            int resultado = carregarCaso(conversao, argv[i + 1]);
+            if (resultado == 0) {
+                congelarCaso(conversao);
+                resultado = salvarCasoBinario(conversao, argv[i + 2]);
             }
-        } else if (escolha == 'd') {
-            if (atual->direita != NULL) {
-                atual = atual->direita;
-            } else {
-                printf(" Não há saída para a direita neste cômodo. Tente outra direção.\n");
+            destruirCaso(conversao);
+            liberarInternos();
+            return resultado == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--gerar-mphf") == 0 && i + 2 < argc) {
+            Caso *geracao = criarCaso();
+            int resultado = carregarCaso(geracao, argv[i + 1]);
+            if (resultado == 0) {
+                resultado = gerarHashPerfeito(geracao, argv[i + 2]);
             }
+            destruirCaso(geracao);
+            liberarInternos();
+            return resultado == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
         } else {
-            printf("Opção inválida. Digite 'e', 'd' ou 's'.\n");
+            mostrarUso(argv[0]);
+            return EXIT_FAILURE;
         }
     }
-    return pistasColetadas; // Retorna a BST de pistas
-}
 
-// Função auxiliar para listar as pistas (In-Order Traversal da BST)
-void listarPistas(NoPista *raiz) {
-    if (raiz != NULL) {
-        listarPistas(raiz->esquerda);
-        printf("- %s\n", raiz->pista);
-        listarPistas(raiz->direita);
+    if (socketServidor != NULL) {
+        if (mostrarTempos || arquivoRoteiro != NULL) {
+            fprintf(stderr, "--servidor não pode ser combinado com --tempos, --trace ou --roteiro.\n");
+            return EXIT_FAILURE;
+        }
+        // As sessões respondem pelo socket; a narração iria toda misturada para o stdout
+        nivel = NIVEL_SILENCIOSO;
     }
-}
-
-/**
- * Conduz à fase de julgamento final.
- * Conta quantas pistas coletadas apontam para o suspeito acusado.
- * A raiz da BST com todas as pistas que o jogador encontrou.
- * O ponteiro para a Tabela Hash de associações Pista/Suspeito.
- */
-void verificarSuspeitoFinal(NoPista *pistasColetadas, TabelaHash *tabelaHash) {
-    char acusado[TAMANHO_MAX_STRING];
-    int contagemPistas = 0;
-
-    printf("\n\n=============== FASE DE JULGAMENTO ==============\n");
-
-    if (pistasColetadas == NULL) {
-        printf(" Você não coletou nenhuma pista. A acusação será apenas um palpite!\n");
-    } else {
-        printf(" Pistas coletadas (em ordem alfabética):\n");
-        listarPistas(pistasColetadas);
+    if (mostrarTempos) {
+        ativarMedicao(arquivoTrace != NULL);
     }
-    
-    printf("\nCom base nas evidências, quem você acusa? (Digite o nome do suspeito): ");
-    scanf("%s", acusado);
-    // Limpa o buffer de entrada
-    while (getchar() != '\n'); 
-
-    printf("\nAnalisando as evidências coletadas contra **%s**...\n", acusado);
 
-    // Função recursiva interna para contar as pistas
-    void contarPistas(NoPista *no) {
-        if (no != NULL) {
-            contarPistas(no->esquerda);
-            
-            const char *suspeitoDaPista = encontrarSuspeito(tabelaHash, no->pista);
-            
-            if (suspeitoDaPista != NULL && strcmp(suspeitoDaPista, acusado) == 0) {
-                contagemPistas++;
-                printf("   [+] Pista '%s' aponta para %s.\n", no->pista, acusado);
+    FILE *entrada = stdin;
+    int interativo = socketServidor == NULL && !varredura;
+    if (arquivoRoteiro != NULL) {
+        if (strcmp(arquivoRoteiro, "-") != 0) {
+            entrada = fopen(arquivoRoteiro, "r");
+            if (entrada == NULL) {
+                perror(arquivoRoteiro);
+                return EXIT_FAILURE;
             }
-            
-            contarPistas(no->direita);
         }
+        interativo = 0;
+    }
+    if (arquivoSessao != NULL && (!interativo || mostrarRelatorio)) {
+        fprintf(stderr, "--sessao só vale no jogo interativo.\n");
+        return EXIT_FAILURE;
+    }
+    if (nivel < 0) {
+        // Roteiro e relatório ficam silenciosos, a não ser com --verboso
+        nivel = (interativo && !mostrarRelatorio) || verboso ? NIVEL_INFO : NIVEL_SILENCIOSO;
     }
+    configurarLog(nivel);
 
-    contarPistas(pistasColetadas);
+    narrar("==========================================\n");
+    narrar("        DETETIVE QUEST - CAPÍTULO FINAL\n");
+    narrar("==========================================\n");
 
-    printf("\n--- RESULTADO DA ANÁLISE ---\n");
-    printf("Número total de pistas contra %s: **%d**\n", acusado, contagemPistas);
+    // Inicialização do caso (arena, Tabela Hash e BST de Pistas)
+    Caso *caso = criarCaso();
 
-    if (contagemPistas >= 2) {
-        printf("\n SUCESSO! **%s** foi formalmente acusado!\n", acusado);
-        printf("Pelo menos duas pistas substanciais (%d) sustentam a sua conclusão. Caso resolvido!\n", contagemPistas);
+    if (arquivoCaso != NULL) {
+        narrar("\n--- Carregando o caso '%s' ---\n", arquivoCaso);
+        if (carregarCaso(caso, arquivoCaso) != 0) {
+            destruirCaso(caso);
+            liberarInternos();
+            encerrarMedicao();
+            return EXIT_FAILURE;
+        }
+        narrar("> Caso carregado: %u associações de pistas.\n", associacoesDoCaso(caso));
     } else {
-        printf("\n FRACASSO! A acusação contra **%s** não pode ser sustentada.\n", acusado);
-        printf("Você precisa de, pelo menos, 2 pistas. A falta de evidências substanciais leva à absolvição.\n");
+        montarCasoPadrao(caso);
     }
-}
-
-// Função para liberar a memória da Árvore Binária da mansão
-void liberarMansao(NoSala *raiz) {
-    if (raiz != NULL) {
-        liberarMansao(raiz->esquerda);
-        liberarMansao(raiz->direita);
-        free(raiz);
+    congelarCaso(caso);
+    if (arquivoPerfeita != NULL && usarHashPerfeito(caso, arquivoPerfeita) != 0) {
+        destruirCaso(caso);
+        liberarInternos();
+        encerrarMedicao();
+        return EXIT_FAILURE;
     }
-}
-
-// Função para liberar a memória da BST de Pistas
-void liberarPistas(NoPista *raiz) {
-    if (raiz != NULL) {
-        liberarPistas(raiz->esquerda);
-        liberarPistas(raiz->direita);
-        free(raiz);
+    if (taxaFiltro > 0.0) {
+        ativarFiltro(caso, taxaFiltro);
     }
-}
-
-// Função para liberar a memória da Tabela Hash
-void liberarHash(TabelaHash *tabela) {
-    for (int i = 0; i < TAMANHO_TABELA_HASH; i++) {
-        HashItem *atual = tabela->itens[i];
-        while (atual != NULL) {
-            HashItem *proximo = atual->proximo;
-            free(atual);
-            atual = proximo;
-        }
-    }
-}
 
-// --- 4. FUNÇÃO PRINCIPAL (MAIN) ---
+    Estatisticas *estatisticas = mostrarEstatisticas ? criarEstatisticas() : NULL;
+    int resultado = EXIT_SUCCESS;
 
-int main() {
-    printf("==========================================\n");
-    printf("        DETETIVE QUEST - CAPÍTULO FINAL\n");
-    printf("==========================================\n");
-
-    // Inicialização da Tabela Hash
-    TabelaHash tabelaPistasSuspeitos;
-    for (int i = 0; i < TAMANHO_TABELA_HASH; i++) {
-        tabelaPistasSuspeitos.itens[i] = NULL;
+    if (mostrarRelatorio) {
+        imprimirRelatorioCaso(stdout, caso);
+    } else if (varredura) {
+        // --- Modo varredura: todas as pistas do caso, contadas em paralelo ---
+        if (executarVarredura(caso, (unsigned int)trabalhadores) != 0) {
+            resultado = EXIT_FAILURE;
+        }
+    } else if (socketServidor != NULL) {
+        // --- Modo servidor: o caso congelado é compartilhado por todas as sessões ---
+        if (executarServidor(caso, socketServidor, (unsigned int)trabalhadores) != 0) {
+            resultado = EXIT_FAILURE;
+        }
+    } else if (!interativo) {
+        // --- Modo roteiro: as mesmas fases do jogo, sessão após sessão ---
+        executarRoteiro(caso, entrada, stdout, estatisticas);
+        if (entrada != stdin) {
+            fclose(entrada);
+        }
+    } else if (jogarInterativo(caso, entrada, arquivoSessao, estatisticas) != 0) {
+        // --- Jogo (ou retomada de uma investigação guardada com --sessao) ---
+        resultado = EXIT_FAILURE;
+    }
+
+    if (estatisticas != NULL) {
+        medirCaso(caso, estatisticas);
+        fflush(stdout);
+        imprimirEstatisticas(stderr, estatisticas);
+        destruirEstatisticas(estatisticas);
+    }
+    if (mostrarTempos) {
+        fflush(stdout);
+        imprimirLatencias(stderr);
+        if (arquivoTrace != NULL && salvarTrace(arquivoTrace) != 0) {
+            resultado = EXIT_FAILURE;
+        }
+        encerrarMedicao();
     }
 
-    // Inicialização da BST de Pistas
-    NoPista *pistasColetadas = NULL;
-
-    // --- Montagem do Mapa Fixo da Mansão (Árvore Binária) ---
-    printf("\n--- Montando a Mansão ---\n");
-
-    // Nível 0 (Raiz)
-    NoSala *hall = criarSala("Hall de Entrada", "Estrela Azul");
-
-    // Nível 1
-    hall->esquerda = criarSala("Cozinha", " Fogao sujo");
-    hall->direita = criarSala("Sala de Jantar", "Pratos sujos na mesa");
-
-    // Nível 2
-    hall->esquerda->esquerda = criarSala("Despensa", "Garrafa de azeite Vazia");
-    hall->esquerda->direita = criarSala("Biblioteca", "Livros fora de armario");
-    hall->direita->esquerda = criarSala("Sala de Estar", "Nenhum"); // Sem pista
-    hall->direita->direita = criarSala("Quarto Principal", "Um pequeno alfinete de lapela");
-
-    // Nível 3
-    hall->esquerda->direita->esquerda = criarSala("Escritório", "Nenhum"); // Sem pista
-    hall->direita->direita->esquerda = criarSala("Banheiro", "papel higienico");
-    hall->direita->direita->direita = criarSala("Closet", "cabelo no chão");
-
-    // --- Montagem das Associações Pista -> Suspeito (Tabela Hash) ---
-    printf("\n--- Definindo as Associações de Pistas ---\n");
-    
-    // Suspeitos: Mordomo (Alfred), Jardineiro (Bartolomeu), Esposa (Cecília)
-    inserirNaHash(&tabelaPistasSuspeitos, "Anel de Prata", "Bartolomeu");
-    inserirNaHash(&tabelaPistasSuspeitos, "Fogão sujo", "Luzia");
-    inserirNaHash(&tabelaPistasSuspeitos, "pratos sujos na mesa", "Sebastiao");
-    inserirNaHash(&tabelaPistasSuspeitos, "Garrafa de Azeite Vazia", "Rafael");
-    inserirNaHash(&tabelaPistasSuspeitos, "Livros fora do armario", "Emilly");
-    inserirNaHash(&tabelaPistasSuspeitos, "Papel higienico", "Cecilia");
-    inserirNaHash(&tabelaPistasSuspeitos, "Tubo de batom vermelho", "Cecilia");
-    inserirNaHash(&tabelaPistasSuspeitos, "Cabelo no chão", "Cecilia");
-
-
-    // --- Início do Jogo ---
-    printf("\n================ INÍCIO DA EXPLORAÇÃO ================\n");
-    
-    // Inicia a exploração da mansão (navegação na Árvore Binária)
-    pistasColetadas = explorarSalas(hall, pistasColetadas, &tabelaPistasSuspeitos);
-    
-    // Conduz a fase de julgamento (Verificação de Suspeito com BST e Hash)
-    verificarSuspeitoFinal(pistasColetadas, &tabelaPistasSuspeitos);
-
     // --- Fim e Limpeza da Memória ---
-    printf("\n--- Fim do Programa. Liberando memória ---\n");
-    liberarMansao(hall);
-    liberarPistas(pistasColetadas);
-    liberarHash(&tabelaPistasSuspeitos);
+    narrar("\n--- Fim do Programa. Liberando memória ---\n");
+    destruirCaso(caso);
+    liberarInternos();
 
-    return 0;
-}
\ No newline at end of file
+    return resultado;
+}
@@ -36,6 +36,8 @@ Sala* criarSala(const char *nome) {
 // Função: explorarSalas
 // Permite ao jogador explorar a mansão a partir da sala atual.
 // O jogador escolhe 'e' (esquerda), 'd' (direita) ou 's' (sair).
+// Cada movimento apenas troca a sala atual (sem recursão), então
+// a pilha não cresce com o número de passos.
 // ---------------------------------------------------------
 void explorarSalas(Sala *atual) {
     char opcao;
@@ -45,46 +47,64 @@ void explorarSalas(Sala *atual) {
         return;
     }
 
-    printf("\nVocê está no(a): %s\n", atual->nome);
+    while (1) {
+        printf("\nVocê está no(a): %s\n", atual->nome);
 
-    // Se não há caminhos, o jogador chegou ao final
-    if (atual->esquerda == NULL && atual->direita == NULL) {
-        printf("Você chegou a um cômodo sem saídas. Fim da exploração!\n");
-        return;
-    }
+        // Se não há caminhos, o jogador chegou ao final
+        if (atual->esquerda == NULL && atual->direita == NULL) {
+            printf("Você chegou a um cômodo sem saídas. Fim da exploração!\n");
+            return;
+        }
 
-    while (1) {
-        printf("\nEscolha um caminho:\n");
-        if (atual->esquerda != NULL) printf(" (e) Ir para a esquerda\n");
-        if (atual->direita != NULL) printf(" (d) Ir para a direita\n");
-        printf(" (s) Sair da exploração\n> ");
-
-        scanf(" %c", &opcao);
-
-        if (opcao == 'e' && atual->esquerda != NULL) {
-            explorarSalas(atual->esquerda);
-            break;
-        } else if (opcao == 'd' && atual->direita != NULL) {
-            explorarSalas(atual->direita);
-            break;
-        } else if (opcao == 's') {
-            printf("\nVocê decidiu encerrar a exploração.\n");
-            break;
-        } else {
-            printf("Opção inválida! Tente novamente.\n");
+        // Pergunta até receber uma opção válida para esta sala
+        Sala *proxima = NULL;
+        while (proxima == NULL) {
+            printf("\nEscolha um caminho:\n");
+            if (atual->esquerda != NULL) printf(" (e) Ir para a esquerda\n");
+            if (atual->direita != NULL) printf(" (d) Ir para a direita\n");
+            printf(" (s) Sair da exploração\n> ");
+
+            if (scanf(" %c", &opcao) != 1) {
+                printf("\nEntrada encerrada.\n");
+                return;
+            }
+
+            if (opcao == 'e' && atual->esquerda != NULL) {
+                proxima = atual->esquerda;
+            } else if (opcao == 'd' && atual->direita != NULL) {
+                proxima = atual->direita;
+            } else if (opcao == 's') {
+                printf("\nVocê decidiu encerrar a exploração.\n");
+                return;
+            } else {
+                printf("Opção inválida! Tente novamente.\n");
+            }
         }
+        atual = proxima;
     }
 }
 
 // ---------------------------------------------------------
 // Função: liberarMemoria
-// Libera toda a memória alocada para as salas.
+// Libera toda a memória alocada para as salas, sem recursão e sem
+// pilha: enquanto a sala atual tiver filho à esquerda, uma rotação
+// à direita o sobe; sem filho à esquerda, ela é liberada e o
+// percurso segue pela direita. Cada rotação desce um nó de vez
+// para a "espinha" da direita, então o total de passos é O(n).
 // ---------------------------------------------------------
 void liberarMemoria(Sala *raiz) {
-    if (raiz == NULL) return;
-    liberarMemoria(raiz->esquerda);
-    liberarMemoria(raiz->direita);
-    free(raiz);
+    while (raiz != NULL) {
+        if (raiz->esquerda != NULL) {
+            Sala *filho = raiz->esquerda;
+            raiz->esquerda = filho->direita;
+            filho->direita = raiz;
+            raiz = filho;
+        } else {
+            Sala *proxima = raiz->direita;
+            free(raiz);
+            raiz = proxima;
+        }
+    }
 }
 
 // ---------------------------------------------------------
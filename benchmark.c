@@ -0,0 +1,470 @@
+// Microbenchmarks das estruturas do Detective Quest
+// Mede ns/op e alocações/op de hash(), inserirNaHash, encontrarSuspeito (na
+// tabela Robin Hood, com o filtro de Bloom e no hash perfeito), inserirPista e
+// listarPistas sobre dados sintéticos reprodutíveis.
+//
+// Uso: benchmark [-n chaves] [-s suspeitos] [-r repeticoes] [-d uniforme|zipf]
+//                [-x semente] [-h rapido|fnv1a|polinomial] [--base resultado_anterior.tsv]
+//
+// Cada linha da saída (TSV) traz a mediana e o mínimo das repetições. Com a
+// mesma semente e os mesmos parâmetros, as entradas são idênticas a cada
+// execução; salve a saída e passe-a em --base para ver a variação.
+// Antes das medidas de consulta, linhas de comentário mostram a distribuição
+// da tabela (ocupação, sondagens e aglomerados) com a função de hash escolhida.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// --- Contagem de alocações ---
+// As chamadas do motor (detective.c) passam pelos contadores abaixo (macros
+// definidas antes de embutir o arquivo, que expõe também as funções internas).
+
+unsigned long long alocacoes = 0;
+unsigned long long bytesAlocados = 0;
+
+void* contarMalloc(size_t tamanho) {
+    alocacoes++;
+    bytesAlocados += tamanho;
+    return malloc(tamanho);
+}
+
+void* contarCalloc(size_t quantidade, size_t tamanho) {
+    alocacoes++;
+    bytesAlocados += quantidade * tamanho;
+    return calloc(quantidade, tamanho);
+}
+
+void* contarRealloc(void *ponteiro, size_t tamanho) {
+    alocacoes++;
+    bytesAlocados += tamanho;
+    return realloc(ponteiro, tamanho);
+}
+
+#define malloc(t) contarMalloc(t)
+#define calloc(q, t) contarCalloc(q, t)
+#define realloc(p, t) contarRealloc(p, t)
+#include "detective.c"
+#undef malloc
+#undef calloc
+#undef realloc
+
+// --- Parâmetros e dados sintéticos ---
+
+#define MAX_REPETICOES 101
+#define TAMANHO_CHAVE 32
+
+typedef struct Parametros {
+    unsigned int chaves;      // Número de pistas distintas
+    unsigned int suspeitos;   // Número de suspeitos distintos
+    unsigned int repeticoes;  // Repetições de cada medida (mediana e mínimo)
+    int zipf;                 // Distribuição das consultas: 0 = uniforme, 1 = Zipf (s = 1)
+    unsigned long long semente;
+    const char *base;         // Resultado anterior para comparação (opcional)
+} Parametros;
+
+// Dados gerados uma vez e reutilizados por todas as medidas
+typedef struct Dados {
+    char (*pistas)[TAMANHO_CHAVE];     // Pistas em ordem aleatória
+    char (*ausentes)[TAMANHO_CHAVE];   // Textos que nunca são inseridos
+    char (*suspeitos)[TAMANHO_CHAVE];
+    unsigned int *suspeitoDaPista;     // Índice do suspeito de cada pista
+    unsigned int *consultas;           // Ordem das consultas (uniforme ou Zipf)
+} Dados;
+
+// Resultado de uma medida
+typedef struct Medida {
+    const char *nome;
+    double nsPorOp;      // Mediana
+    double nsPorOpMin;   // Mínimo
+    double alocPorOp;
+    double bytesPorOp;
+} Medida;
+
+// Gerador xorshift64*: rápido e reprodutível em qualquer plataforma
+unsigned long long estadoAleatorio;
+
+unsigned long long proximoAleatorio(void) {
+    estadoAleatorio ^= estadoAleatorio >> 12;
+    estadoAleatorio ^= estadoAleatorio << 25;
+    estadoAleatorio ^= estadoAleatorio >> 27;
+    return estadoAleatorio * 2685821657736338717ULL;
+}
+
+double agoraNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+void* alocarOuSair(size_t tamanho) {
+    void *p = malloc(tamanho);
+    if (p == NULL) {
+        perror("Erro de alocação de memória no benchmark");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+void gerarDados(const Parametros *parametros, Dados *dados) {
+    unsigned int n = parametros->chaves;
+    dados->pistas = alocarOuSair(n * sizeof(*dados->pistas));
+    dados->ausentes = alocarOuSair(n * sizeof(*dados->ausentes));
+    dados->suspeitos = alocarOuSair(parametros->suspeitos * sizeof(*dados->suspeitos));
+    dados->suspeitoDaPista = alocarOuSair(n * sizeof(unsigned int));
+    dados->consultas = alocarOuSair(n * sizeof(unsigned int));
+
+    estadoAleatorio = parametros->semente;
+    for (unsigned int i = 0; i < parametros->suspeitos; i++) {
+        snprintf(dados->suspeitos[i], TAMANHO_CHAVE, "Suspeito %u", i);
+    }
+    // Pistas numeradas em sequência e depois embaralhadas (Fisher-Yates)
+    for (unsigned int i = 0; i < n; i++) {
+        snprintf(dados->pistas[i], TAMANHO_CHAVE, "Pista %08u", i);
+        snprintf(dados->ausentes[i], TAMANHO_CHAVE, "Ausente %08u", i);
+        dados->suspeitoDaPista[i] = (unsigned int)(proximoAleatorio() % parametros->suspeitos);
+    }
+    for (unsigned int i = n - 1; i > 0; i--) {
+        unsigned int j = (unsigned int)(proximoAleatorio() % (i + 1));
+        char tmp[TAMANHO_CHAVE];
+        memcpy(tmp, dados->pistas[i], TAMANHO_CHAVE);
+        memcpy(dados->pistas[i], dados->pistas[j], TAMANHO_CHAVE);
+        memcpy(dados->pistas[j], tmp, TAMANHO_CHAVE);
+    }
+
+    if (!parametros->zipf) {
+        for (unsigned int i = 0; i < n; i++) {
+            dados->consultas[i] = (unsigned int)(proximoAleatorio() % n);
+        }
+    } else {
+        // Zipf com s = 1: a k-ésima pista é consultada com peso 1/k
+        double *acumulada = alocarOuSair(n * sizeof(double));
+        double soma = 0.0;
+        for (unsigned int k = 0; k < n; k++) {
+            soma += 1.0 / (double)(k + 1);
+            acumulada[k] = soma;
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            double alvo = ((double)(proximoAleatorio() >> 11) / 9007199254740992.0) * soma;
+            unsigned int baixo = 0, alto = n - 1;
+            while (baixo < alto) {
+                unsigned int meio = (baixo + alto) / 2;
+                if (acumulada[meio] < alvo) baixo = meio + 1; else alto = meio;
+            }
+            dados->consultas[i] = baixo;
+        }
+        free(acumulada);
+    }
+}
+
+void liberarDados(Dados *dados) {
+    free(dados->pistas);
+    free(dados->ausentes);
+    free(dados->suspeitos);
+    free(dados->suspeitoDaPista);
+    free(dados->consultas);
+}
+
+// --- Medidas ---
+// Cada função executa uma repetição: prepara o que precisar fora do tempo
+// medido e devolve os nanossegundos da parte medida.
+
+typedef double (*FuncaoMedida)(const Parametros *parametros, const Dados *dados);
+
+volatile unsigned long long sumidouro; // Impede o compilador de descartar resultados
+
+double medirHash(const Parametros *parametros, const Dados *dados) {
+    unsigned long long acumulado = 0;
+    double inicio = agoraNs();
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        acumulado += hash(dados->pistas[i]);
+    }
+    double fim = agoraNs();
+    sumidouro = acumulado;
+    return fim - inicio;
+}
+
+// Monta uma tabela com todas as associações (usado fora do tempo medido)
+void preencherTabela(TabelaHash *tabela, const Parametros *parametros, const Dados *dados) {
+    inicializarHash(tabela);
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        inserirNaHash(tabela, dados->pistas[i], dados->suspeitos[dados->suspeitoDaPista[i]]);
+    }
+}
+
+double medirInserirNaHash(const Parametros *parametros, const Dados *dados) {
+    TabelaHash tabela;
+    liberarInternos();
+    inicializarHash(&tabela);
+    double inicio = agoraNs();
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        inserirNaHash(&tabela, dados->pistas[i], dados->suspeitos[dados->suspeitoDaPista[i]]);
+    }
+    double fim = agoraNs();
+    liberarHash(&tabela);
+    return fim - inicio;
+}
+
+// Tabela compartilhada pelas medidas de consulta (montada uma única vez)
+TabelaHash tabelaConsultas;
+
+double medirEncontrarAcerto(const Parametros *parametros, const Dados *dados) {
+    unsigned long long encontrados = 0;
+    double inicio = agoraNs();
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        encontrados += encontrarSuspeito(&tabelaConsultas, dados->pistas[dados->consultas[i]]) != NULL;
+    }
+    double fim = agoraNs();
+    sumidouro = encontrados;
+    return fim - inicio;
+}
+
+double medirEncontrarFalha(const Parametros *parametros, const Dados *dados) {
+    unsigned long long encontrados = 0;
+    double inicio = agoraNs();
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        encontrados += encontrarSuspeito(&tabelaConsultas, dados->ausentes[dados->consultas[i]]) != NULL;
+    }
+    double fim = agoraNs();
+    sumidouro = encontrados;
+    return fim - inicio;
+}
+
+// Ids das pistas já internadas, na ordem aleatória e em ordem alfabética
+IdTexto *idsAleatorios;
+IdTexto *idsOrdenados;
+
+int compararIdsPorTexto(const void *a, const void *b) {
+    return strcmp(textoDoId(*(const IdTexto*)a), textoDoId(*(const IdTexto*)b));
+}
+
+double medirInserirPista(const Parametros *parametros, const IdTexto *ids) {
+    Arena arena = { NULL };
+    NoPista *raiz = NULL;
+    double inicio = agoraNs();
+    for (unsigned int i = 0; i < parametros->chaves; i++) {
+        raiz = inserirPista(&arena, raiz, ids[i], NULL);
+    }
+    double fim = agoraNs();
+    sumidouro = (unsigned long long)alturaPista(raiz);
+    liberarArena(&arena);
+    return fim - inicio;
+}
+
+double medirInserirPistaAleatoria(const Parametros *parametros, const Dados *dados) {
+    (void)dados;
+    return medirInserirPista(parametros, idsAleatorios);
+}
+
+double medirInserirPistaOrdenada(const Parametros *parametros, const Dados *dados) {
+    (void)dados;
+    return medirInserirPista(parametros, idsOrdenados);
+}
+
+// Árvore compartilhada pela medida de listagem (stdout vai para /dev/null)
+NoPista *arvoreListagem;
+
+double medirListarPistas(const Parametros *parametros, const Dados *dados) {
+    (void)parametros;
+    (void)dados;
+    fflush(stdout);
+    int stdoutOriginal = dup(STDOUT_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    dup2(nulo, STDOUT_FILENO);
+    close(nulo);
+
+    double inicio = agoraNs();
+    listarPistas(arvoreListagem);
+    fflush(stdout);
+    double fim = agoraNs();
+
+    dup2(stdoutOriginal, STDOUT_FILENO);
+    close(stdoutOriginal);
+    return fim - inicio;
+}
+
+int compararDouble(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Executa uma medida várias vezes (mais uma de aquecimento) e resume os tempos
+Medida executarMedida(const char *nome, FuncaoMedida funcao, const Parametros *parametros, const Dados *dados) {
+    double tempos[MAX_REPETICOES];
+    Medida medida;
+    medida.nome = nome;
+
+    funcao(parametros, dados); // Aquecimento (caches, páginas, preditor)
+
+    unsigned long long alocacoesAntes = alocacoes, bytesAntes = bytesAlocados;
+    for (unsigned int r = 0; r < parametros->repeticoes; r++) {
+        tempos[r] = funcao(parametros, dados);
+    }
+    double totalOps = (double)parametros->chaves * parametros->repeticoes;
+    medida.alocPorOp = (double)(alocacoes - alocacoesAntes) / totalOps;
+    medida.bytesPorOp = (double)(bytesAlocados - bytesAntes) / totalOps;
+
+    qsort(tempos, parametros->repeticoes, sizeof(double), compararDouble);
+    medida.nsPorOp = tempos[parametros->repeticoes / 2] / parametros->chaves;
+    medida.nsPorOpMin = tempos[0] / parametros->chaves;
+    return medida;
+}
+
+// Procura o ns/op (mediana) de uma medida num resultado anterior; -1 se não houver
+double procurarNaBase(const char *caminho, const char *nome) {
+    FILE *arquivo = fopen(caminho, "r");
+    if (arquivo == NULL) {
+        return -1.0;
+    }
+    char linha[512];
+    double valor = -1.0;
+    while (fgets(linha, sizeof(linha), arquivo) != NULL) {
+        size_t tamanho = strlen(nome);
+        if (strncmp(linha, nome, tamanho) == 0 && linha[tamanho] == '\t') {
+            valor = strtod(linha + tamanho + 1, NULL);
+            break;
+        }
+    }
+    fclose(arquivo);
+    return valor;
+}
+
+void imprimirMedida(const Medida *medida, const Parametros *parametros) {
+    printf("%s\t%.2f\t%.2f\t%.3f\t%.1f", medida->nome, medida->nsPorOp, medida->nsPorOpMin,
+           medida->alocPorOp, medida->bytesPorOp);
+    if (parametros->base != NULL) {
+        double anterior = procurarNaBase(parametros->base, medida->nome);
+        if (anterior > 0.0) {
+            printf("\t%+.1f%%", 100.0 * (medida->nsPorOp - anterior) / anterior);
+        } else {
+            printf("\t-");
+        }
+    }
+    printf("\n");
+}
+
+void mostrarUsoBenchmark(const char *programa) {
+    fprintf(stderr, "Uso: %s [-n chaves] [-s suspeitos] [-r repeticoes] [-d uniforme|zipf] [-x semente] [-h rapido|fnv1a|polinomial] [--base arquivo.tsv]\n", programa);
+}
+
+int main(int argc, char *argv[]) {
+    Parametros parametros = { 100000, 1000, 9, 0, 0x9E3779B97F4A7C15ULL, NULL };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            parametros.chaves = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            parametros.suspeitos = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            parametros.repeticoes = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            parametros.zipf = strcmp(argv[++i], "zipf") == 0;
+        } else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            parametros.semente = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            if (!selecionarHash(argv[++i])) {
+                mostrarUsoBenchmark(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--base") == 0 && i + 1 < argc) {
+            parametros.base = argv[++i];
+        } else {
+            mostrarUsoBenchmark(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (parametros.chaves < 2 || parametros.suspeitos == 0 || parametros.semente == 0 ||
+        parametros.repeticoes == 0 || parametros.repeticoes > MAX_REPETICOES) {
+        mostrarUsoBenchmark(argv[0]);
+        return EXIT_FAILURE;
+    }
+    nivelLog = NIVEL_SILENCIOSO; // inserirNaHash não narra nada durante as medidas
+
+    Dados dados;
+    gerarDados(&parametros, &dados);
+
+    printf("# chaves=%u suspeitos=%u repeticoes=%u consultas=%s semente=0x%llx\n",
+           parametros.chaves, parametros.suspeitos, parametros.repeticoes,
+           parametros.zipf ? "zipf" : "uniforme", parametros.semente);
+    printf("# medida\tns/op\tns/op(min)\taloc/op\tbytes/op%s\n", parametros.base != NULL ? "\tvariacao" : "");
+
+    Medida medida;
+    medida = executarMedida("hash", medirHash, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    medida = executarMedida("inserirNaHash", medirInserirNaHash, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+
+    // As consultas e a árvore usam um único conjunto de internados montado aqui
+    liberarInternos();
+    preencherTabela(&tabelaConsultas, &parametros, &dados);
+    RelatorioHash relatorio;
+    relatorioHash(&tabelaConsultas, &relatorio);
+    imprimirRelatorioHash(stdout, "# ", "associacoes", &relatorio);
+    relatorioInternos(&relatorio);
+    imprimirRelatorioHash(stdout, "# ", "internados", &relatorio);
+    medida = executarMedida("encontrarSuspeito_acerto", medirEncontrarAcerto, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    medida = executarMedida("encontrarSuspeito_falha", medirEncontrarFalha, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+
+    // Pistas conhecidas (internadas) mas sem associação: a busca chega à tabela,
+    // e é aí que o filtro de Bloom (1% de falsos positivos) pode cortar a sondagem
+    for (unsigned int i = 0; i < parametros.chaves; i++) {
+        internarTexto(dados.ausentes[i]);
+    }
+    medida = executarMedida("encontrarSuspeito_sem_associacao", medirEncontrarFalha, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    construirFiltro(&tabelaConsultas, 0.01);
+    medida = executarMedida("encontrarSuspeito_filtro_acerto", medirEncontrarAcerto, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    medida = executarMedida("encontrarSuspeito_filtro_sem_associacao", medirEncontrarFalha, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    recolherContadoresFiltro();
+    printf("# filtro: %u blocos, k = %u, %lu consultas, %lu descartadas, %lu falsos positivos\n",
+           tabelaConsultas.blocosFiltro, tabelaConsultas.funcoesFiltro, totaisFiltro.consultas,
+           totaisFiltro.rejeitadas, totaisFiltro.falsosPositivos);
+
+    // As mesmas consultas depois de passar a tabela para o hash perfeito mínimo
+    double inicioPerfeita = agoraNs();
+    if (gerarPerfeita(&tabelaConsultas) == 0) {
+        printf("# hash perfeito: %u baldes, gerado em %.1f ms\n", tabelaConsultas.numBaldes,
+               (agoraNs() - inicioPerfeita) / 1e6);
+        medida = executarMedida("encontrarSuspeito_perfeito_acerto", medirEncontrarAcerto, &parametros, &dados);
+        imprimirMedida(&medida, &parametros);
+        medida = executarMedida("encontrarSuspeito_perfeito_falha", medirEncontrarFalha, &parametros, &dados);
+        imprimirMedida(&medida, &parametros);
+    }
+
+    idsAleatorios = alocarOuSair(parametros.chaves * sizeof(IdTexto));
+    idsOrdenados = alocarOuSair(parametros.chaves * sizeof(IdTexto));
+    for (unsigned int i = 0; i < parametros.chaves; i++) {
+        idsAleatorios[i] = buscarTexto(dados.pistas[i]);
+        idsOrdenados[i] = idsAleatorios[i];
+    }
+    qsort(idsOrdenados, parametros.chaves, sizeof(IdTexto), compararIdsPorTexto);
+
+    medida = executarMedida("inserirPista_aleatoria", medirInserirPistaAleatoria, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+    medida = executarMedida("inserirPista_ordenada", medirInserirPistaOrdenada, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+
+    Arena arenaListagem = { NULL };
+    arvoreListagem = NULL;
+    for (unsigned int i = 0; i < parametros.chaves; i++) {
+        arvoreListagem = inserirPista(&arenaListagem, arvoreListagem, idsAleatorios[i], NULL);
+    }
+    medida = executarMedida("listarPistas", medirListarPistas, &parametros, &dados);
+    imprimirMedida(&medida, &parametros);
+
+    liberarArena(&arenaListagem);
+    free(idsAleatorios);
+    free(idsOrdenados);
+    liberarHash(&tabelaConsultas);
+    liberarInternos();
+    liberarDados(&dados);
+    return EXIT_SUCCESS;
+}
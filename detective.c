@@ -0,0 +1,4363 @@
+// Detective Quest - motor do jogo (libdetective), a implementação de detective.h.
+// Textos internados, mansão compacta, árvore de pistas (AVL), tabela hash Robin Hood
+// (com filtro de Bloom e hash perfeito opcionais), formatos .txt/.dqc/.dqs/.dqm,
+// modos roteiro, varredura e servidor. Só o que está em detective.h é público.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h> // Para tolower
+#include <strings.h> // Para strncasecmp
+#include <stdint.h>
+#include <limits.h>    // Para UINT_MAX
+#include <stdarg.h>    // Para narrar
+#include <fcntl.h>     // Para open
+#include <unistd.h>    // Para close
+#include <sys/mman.h>  // Para mmap (leitura dos arquivos de caso)
+#include <sys/stat.h>  // Para fstat
+#include <time.h>      // Para clock_gettime (medição de latência)
+#include <errno.h>
+#include <signal.h>    // Para sigwait (encerramento do servidor)
+#include <pthread.h>   // Trabalhadores do modo servidor
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>    // Socket de domínio Unix
+
+#include "detective.h"
+
+// Constantes
+#define TAMANHO_MAX_STRING 50
+#define TAMANHO_TABELA_HASH 16 // Capacidade inicial (potência de dois); a tabela cresce sob demanda
+#define CARGA_MAXIMA_NUM 7     // A tabela dobra quando a ocupação passa de 7/8
+#define CARGA_MAXIMA_DEN 8
+#define ALTURA_MAXIMA_AVL 64   // Uma AVL com altura 64 teria mais de 2^44 nós: folga de sobra para o caminho
+
+#define TAMANHO_INICIAL_INTERNOS 64 // Capacidade inicial do conjunto de strings internadas
+#define TAMANHO_BLOCO_ARENA (64 * 1024) // Bytes úteis de cada bloco da arena
+#define ALINHAMENTO_ARENA 16            // Alinhamento de toda alocação feita na arena
+#define MAGICO_CASO_BINARIO "DQC1"      // Assinatura dos arquivos de caso binários
+#define MAGICO_SESSAO "DQS1"            // Assinatura dos arquivos de sessão salva
+#define MAGICO_PERFEITA "DQM1"          // Assinatura dos arquivos de hash perfeito
+#define CHAVES_POR_BALDE 4              // Média de chaves por balde no hash perfeito
+#define LIMITE_PILOTO (1u << 24)        // Pilotos tentados por balde antes de trocar a semente
+#define TENTATIVAS_SEMENTE 16           // Sementes tentadas antes de desistir do hash perfeito
+#define BITS_BLOCO_FILTRO 512           // Bloco do filtro de Bloom (uma linha de cache): cada chave cai num só
+#define BITS_BLOCO_ROTAS 32             // Posições por bloco no índice de rotas (uma máscara de 32 bits)
+#define SALA_SEM_PAI 0xFFFFFFFFu        // Índice de pai da raiz no formato binário
+#define TAMANHO_MAXIMO_TEXTO UINT16_MAX // Maior texto que cabe nos formatos binários (tamanho em u16)
+#define SEM_SALA 0xFFFFFFFFu            // Filho inexistente na mansão compacta
+#define SEM_SUSPEITO 0xFFFFFFFFu        // Texto que não é nome de nenhum suspeito
+#define TAMANHO_LINHA_COMANDO 256       // Maior linha aceita como comando ou acusação
+#define TAMANHO_BUFFER_SAIDA (1 << 20)  // Buffer de stdout (descarregado antes de cada leitura interativa)
+#define PISTAS_PARA_CONDENAR 2          // Mínimo de pistas para sustentar a acusação
+#define TAMANHO_RANKING 3               // Suspeitos mostrados no ranking dos mais citados
+#define SALAS_MOSTRADAS_PISTA 5         // Salas listadas pelo comando 'onde <pista>'
+#define FAIXAS_SONDAGEM 8               // Faixas do histograma de sondagens (a última acumula o resto)
+#define SUBFAIXAS_LATENCIA 16           // Subdivisões de cada potência de dois no histograma de latência
+#define FAIXAS_LATENCIA (64 + 58 * SUBFAIXAS_LATENCIA) // 0..63 ns exatos, depois 2^6..2^63 subdivididos
+#define MAXIMO_EVENTOS_TRACE (1u << 20) // Eventos guardados para o trace; os seguintes são descartados
+#define TAMANHO_LOTE_REDUCAO 4096       // Pistas que um trabalhador pega de cada vez na redução paralela
+
+// Função de hash usada quando nenhuma é escolhida em tempo de execução.
+// Troque na compilação, ex.: make CFLAGS="-g -Wall -DHASH_PADRAO=hashPolinomial"
+#ifndef HASH_PADRAO
+#define HASH_PADRAO hashRapido
+#endif
+
+// Narração por nível (NIVEL_* em detective.h): mensagens acima de nivelLog nem
+// chegam a ser formatadas. A saída de dados (linhas VEREDITO, relatórios pedidos)
+// não passa por aqui.
+#define LOG(nivel, ...) do { if (nivelLog >= (nivel)) printf(__VA_ARGS__); } while (0)
+#define SAIDA(...) LOG(NIVEL_INFO, __VA_ARGS__)
+#define DEPURACAO(...) LOG(NIVEL_DEPURACAO, __VA_ARGS__)
+
+// Cronômetro de uma fase: INICIAR_MEDIDA devolve 0 sem ler o relógio quando a
+// medição está desligada, e TERMINAR_MEDIDA ignora inícios 0. Compilar com
+// -DDETECTIVE_SEM_MEDICAO remove as medições por completo.
+#ifdef DETECTIVE_SEM_MEDICAO
+#define INICIAR_MEDIDA() ((uint64_t)0)
+#define TERMINAR_MEDIDA(fase, inicio) ((void)(inicio))
+#else
+#define INICIAR_MEDIDA() (medicao.ativa ? relogioNs() : (uint64_t)0)
+#define TERMINAR_MEDIDA(fase, inicio) do { if (inicio) registrarMedida((fase), (inicio)); } while (0)
+#endif
+
+// --- 1. ESTRUTURAS DE DADOS ---
+
+// Identificador de uma string internada. Duas strings iguais têm sempre o mesmo id,
+// então comparar igualdade de textos vira comparar dois inteiros.
+typedef unsigned int IdTexto;
+#define TEXTO_VAZIO 0               // Id reservado para a string vazia ("sem pista")
+#define TEXTO_INEXISTENTE 0xFFFFFFFFu // Retorno de buscarTexto quando a string nunca foi internada
+
+// Conjunto global de strings internadas: cada texto distinto é guardado uma única vez
+typedef struct TabelaInterna {
+    char *blob;                  // Todas as strings, terminadas em '\0', lado a lado
+    size_t tamanhoBlob;
+    size_t capacidadeBlob;
+    size_t *deslocamentos;       // id -> início da string no blob
+    unsigned int *hashes;        // id -> hash completo da string (evita recalcular)
+    IdTexto *chaves;             // id -> id da forma normalizada do texto (ver normalizarChave)
+    unsigned int quantidade;     // Número de ids já atribuídos
+    unsigned int capacidadeIds;
+    IdTexto *posicoes;           // Endereçamento aberto: id + 1 (0 = posição livre)
+    unsigned int capacidadePosicoes; // Sempre potência de dois
+} TabelaInterna;
+
+// Estrutura para o Nó da Árvore Binária (Mansão)
+typedef struct NoSala {
+    IdTexto nome;
+    IdTexto pista; // Pista estática associada à sala (TEXTO_VAZIO se não houver)
+    struct NoSala *esquerda;
+    struct NoSala *direita;
+} NoSala;
+
+// Estrutura para o Nó da Árvore AVL (Pistas Coletadas)
+// A árvore é ordenada e deduplicada pela chave normalizada; 'pista' guarda o texto como foi visto.
+typedef struct NoPista {
+    IdTexto pista;
+    IdTexto chave;     // Forma normalizada da pista
+    uint32_t prefixo;  // Primeiros 4 bytes da chave (big-endian): decide a maioria das comparações
+    int altura; // Altura da subárvore enraizada neste nó (folha = 1)
+    struct NoPista *esquerda;
+    struct NoPista *direita;
+} NoPista;
+
+// Percurso em ordem (alfabética) da árvore de pistas com pilha explícita.
+// A AVL tem altura O(log n), então ALTURA_MAXIMA_AVL posições sempre bastam.
+typedef struct PercursoPistas {
+    const NoPista *pilha[ALTURA_MAXIMA_AVL];
+    int topo;
+} PercursoPistas;
+
+// Estrutura para um Item da Tabela Hash (Associação Pista -> Suspeito)
+typedef struct HashItem {
+    IdTexto pista;               // Id da chave normalizada da pista
+    unsigned int hash;           // Hash completo da chave (a sondagem e o redimensionamento não voltam às strings);
+                                 // no hash perfeito, os 32 bits altos do hash com semente
+    unsigned int indiceSuspeito; // Número denso do suspeito (0 .. numSuspeitos-1)
+    unsigned int posicaoNaLista; // Posição desta pista na lista reversa do suspeito
+    unsigned int distancia; // Distância até a posição ideal + 1 (0 = posição livre)
+} HashItem;
+
+// Índice reverso: todas as pistas associadas a um suspeito
+typedef struct ListaPistas {
+    IdTexto *pistas;             // Texto original de cada pista (a grafia da associação, não a chave)
+    unsigned int quantidade;
+    unsigned int capacidade;
+} ListaPistas;
+
+// Estrutura para a Tabela Hash (endereçamento aberto com Robin Hood)
+typedef struct TabelaHash {
+    HashItem *itens;          // Vetor contíguo de posições
+    unsigned int capacidade;  // Sempre potência de dois
+    unsigned int quantidade;  // Número de associações armazenadas
+    // Suspeitos recebem números densos para que contadores por suspeito sejam vetores
+    IdTexto *suspeitos;              // Número do suspeito -> id do nome
+    ListaPistas *pistasDoSuspeito;   // Número do suspeito -> pistas associadas a ele
+    unsigned int numSuspeitos;
+    unsigned int capacidadeSuspeitos;
+    unsigned int *suspeitoDoTexto;   // Id da chave normalizada -> número do suspeito (SEM_SUSPEITO)
+    unsigned int tamanhoSuspeitoDoTexto;
+    // Hash perfeito mínimo (caso congelado): o item de cada chave fica em itens[posição],
+    // com capacidade == quantidade. NULL = tabela Robin Hood comum.
+    uint32_t *pilotos;       // Balde -> piloto que espalha as chaves dele sem colisão
+    uint32_t numBaldes;
+    uint64_t semente;
+    // Filtro de Bloom das chaves (opcional): descarta com alguns testes de bits
+    // as pistas sem associação, antes de qualquer sondagem. NULL = sem filtro.
+    uint64_t *filtro;        // blocosFiltro blocos de BITS_BLOCO_FILTRO bits
+    uint32_t blocosFiltro;
+    unsigned int funcoesFiltro; // Bits marcados por chave (k)
+} TabelaHash;
+
+// Bloco de memória da arena; os nós são cortados sequencialmente de 'dados'
+typedef struct BlocoArena {
+    struct BlocoArena *anterior; // Blocos formam uma pilha (o mais novo no topo)
+    size_t usado;
+    size_t capacidade;
+    unsigned char dados[];
+} BlocoArena;
+
+// Arena (região) de alocação: não há liberação individual, só da arena inteira
+typedef struct Arena {
+    BlocoArena *atual;
+} Arena;
+
+// Sala da mansão congelada: 16 bytes, filhos por índice de 32 bits.
+// Os textos ficam no blob do conjunto de strings internadas.
+typedef struct SalaCompacta {
+    IdTexto nome;
+    IdTexto pista;     // TEXTO_VAZIO se não houver pista
+    uint32_t esquerda; // Índice do filho em MansaoCompacta.salas (SEM_SALA se não houver)
+    uint32_t direita;
+} SalaCompacta;
+
+// Índice de rotas da mansão congelada: pai e profundidade de cada sala e o
+// ancestral comum de duas salas em O(1).
+//
+// Na ordem de visita em profundidade (pré-ordem), entre uma sala u e uma sala v
+// visitada depois dela, a sala mais rasa é filha do ancestral comum. Como as
+// salas estão em ordem de largura, a mais rasa é a de menor índice: basta o
+// mínimo de um intervalo de 'preordem'. Esse mínimo sai de uma tabela esparsa
+// sobre blocos de BITS_BLOCO_ROTAS posições e, dentro de um bloco, de uma
+// máscara por posição com os candidatos a mínimo (a pilha de menores vistos).
+typedef struct IndiceRotas {
+    uint32_t *pais;          // Sala -> sala de cima (SEM_SALA no Hall)
+    uint32_t *profundidades; // Sala -> profundidade (Hall = 0)
+    uint32_t *entrada;       // Sala -> posição na pré-ordem
+    uint32_t *preordem;      // Posição na pré-ordem -> sala
+    uint32_t *mascaras;      // Posição -> bits (no bloco) dos mínimos de sufixo até ela
+    uint32_t *minimosBlocos; // Nível k, bloco b -> menor sala dos blocos b .. b + 2^k - 1
+    uint32_t numBlocos;
+    uint32_t niveis;
+} IndiceRotas;
+
+// Índices da mansão congelada por texto: endereçados pelo id da chave
+// normalizada (como suspeitoDoTexto), então achar uma sala pelo nome ou as
+// salas de uma pista custa uma busca nos internados e uma leitura.
+typedef struct IndiceSalas {
+    uint32_t *salaDoNome;    // Chave do nome -> sala mais próxima do Hall com esse nome (SEM_SALA se nenhuma)
+    uint32_t *inicioDaPista; // Chave da pista -> início da sua faixa em salasDaPista (tamanho + 1 posições)
+    uint32_t *salasDaPista;  // As salas de cada pista lado a lado, em ordem de largura
+    uint32_t tamanho;        // Chaves cobertas: 0 .. maior chave de nome ou pista
+} IndiceSalas;
+
+// Mansão somente leitura: salas num vetor contíguo em ordem de largura (BFS).
+// salas[0] é o Hall de Entrada e os filhos de uma sala ficam lado a lado.
+typedef struct MansaoCompacta {
+    SalaCompacta *salas;
+    uint32_t quantidade;
+    IndiceRotas rotas;
+    IndiceSalas indice;
+} MansaoCompacta;
+
+// Marca de posição numa arena: restaurarArena devolve tudo o que foi alocado depois dela
+typedef struct MarcaArena {
+    BlocoArena *bloco;
+    size_t usado;
+} MarcaArena;
+
+// De onde vêm os comandos do jogador: o teclado ou um roteiro (arquivo/pipe)
+typedef struct FonteComandos {
+    FILE *arquivo;
+    int interativa; // 1 = mostra os prompts e espera o jogador
+    int fim;        // 1 quando a entrada acabou
+} FonteComandos;
+
+// Resultado de uma fase de julgamento
+typedef struct Veredito {
+    char acusado[TAMANHO_LINHA_COMANDO];
+    int pistas;   // Pistas coletadas que apontam para o acusado
+    int sucesso;  // 1 se a acusação foi sustentada
+} Veredito;
+
+// Índice provisório usado ao montar a mansão a partir de um arquivo de caso:
+// a n-ésima sala declarada fica em salas[n] para que os filhos achem o pai.
+typedef struct MontadorMansao {
+    NoSala **salas;
+    unsigned int quantidade;
+    unsigned int capacidade;
+} MontadorMansao;
+
+// Pista coletada que aponta para um suspeito (lista encadeada por suspeito, na arena)
+typedef struct EvidenciaColetada {
+    IdTexto pista;
+    struct EvidenciaColetada *anterior; // Coletada antes desta (NULL na primeira)
+} EvidenciaColetada;
+
+// Estado de um jogador investigando um caso. Os contadores de evidência são
+// atualizados no momento em que uma pista nova entra na árvore, então o
+// veredito para qualquer acusado é uma leitura direta.
+//
+// O ranking é uma permutação dos suspeitos mantida em ordem decrescente de
+// evidências. Como cada contador só sobe de 1 em 1, basta trocar o suspeito
+// com o primeiro do seu grupo de mesma contagem: O(1) por pista, e os k mais
+// citados são simplesmente as k primeiras posições.
+struct Investigacao {
+    Arena *arena;               // De onde saem os nós e os contadores (do caso)
+    NoPista *pistas;            // Árvore AVL das pistas coletadas
+    unsigned int *evidencias;   // Número do suspeito -> pistas coletadas contra ele
+    unsigned int numSuspeitos;
+    unsigned int *ordem;        // Posição no ranking -> número do suspeito
+    unsigned int *posicao;      // Número do suspeito -> posição no ranking
+    unsigned int *acima;        // Contagem c -> quantos suspeitos têm mais de c evidências
+    unsigned int tamanhoAcima;
+    struct EvidenciaColetada **coletadasContra; // Número do suspeito -> pistas coletadas contra ele
+    unsigned long pistasRepetidas; // Visitas a salas cuja pista já tinha sido coletada
+    uint32_t sala;              // Sala onde o jogador está (índice na mansão compacta)
+    int explorada;              // 1 depois que o jogador encerrou a exploração ('s')
+};
+
+// Um caso investigado: dono de toda a memória da mansão, das associações e das pistas
+struct Caso {
+    Arena arena;               // Nós da árvore de pistas
+    Arena arenaMontagem;       // Nós NoSala, usados só até a mansão ser congelada
+    NoSala *mansao;            // Raiz da mansão em montagem (NULL depois de congelar)
+    MansaoCompacta mapa;       // Mansão congelada, usada durante o jogo
+    TabelaHash associacoes;    // Pista -> Suspeito
+};
+
+
+// Função de hash de strings: recebe os bytes e o tamanho, devolve o valor completo
+typedef unsigned int (*FuncaoHash)(const char *chave, size_t tamanho);
+
+// Qualidade da distribuição de uma tabela de endereçamento aberto
+typedef struct RelatorioHash {
+    unsigned int capacidade;
+    unsigned int ocupadas;
+    unsigned int sondagemMaxima;     // Maior número de posições visitadas para achar uma chave
+    unsigned long long somaSondagens; // Soma das sondagens de todas as chaves (média = soma / ocupadas)
+    unsigned int maiorAglomerado;    // Maior sequência de posições ocupadas seguidas
+    unsigned int histograma[FAIXAS_SONDAGEM]; // Chaves achadas com 1, 2, ... sondagens
+} RelatorioHash;
+
+// Memória viva de uma estrutura: bytes reservados e blocos obtidos do malloc
+typedef struct MemoriaEstrutura {
+    size_t bytes;
+    unsigned long alocacoes;
+} MemoriaEstrutura;
+
+// Contadores do filtro de Bloom. Cada thread conta nos seus (sem disputa na
+// busca) e os soma nos totais com recolherContadoresFiltro ao terminar.
+typedef struct ContadoresFiltro {
+    unsigned long consultas;       // Buscas que passaram pelo filtro
+    unsigned long rejeitadas;      // Descartadas pelo filtro, sem tocar na tabela
+    unsigned long falsosPositivos; // Aceitas pelo filtro, mas sem associação
+} ContadoresFiltro;
+
+// Números de uma execução (opção --stats). As investigações são acumuladas
+// uma a uma; o restante é medido sobre o caso no fim.
+struct Estatisticas {
+    // Árvores de pistas coletadas, somadas sobre as investigações medidas
+    unsigned long investigacoes;
+    unsigned long nosPistas;
+    unsigned int alturaMaximaPistas;
+    unsigned long long somaProfundidades; // Raiz na profundidade 0
+    unsigned long pistasRepetidas;
+    // Tabelas hash
+    RelatorioHash associacoes;
+    RelatorioHash internados;
+    // Mansão congelada
+    unsigned int salas;
+    unsigned int profundidadeMansao; // Hall = 0
+    unsigned int folhas;
+    // Filtro de Bloom das associações (bitsFiltro = 0 se não houver)
+    unsigned long long bitsFiltro;
+    unsigned int funcoesFiltro;
+    unsigned int chavesFiltro;
+    ContadoresFiltro filtro;
+    // Memória por estrutura
+    MemoriaEstrutura memoriaArena;     // Pico da arena do caso (árvores de pistas e contadores)
+    MemoriaEstrutura memoriaHash;      // Associações, suspeitos e índice reverso
+    MemoriaEstrutura memoriaInternos;  // Textos internados
+    MemoriaEstrutura memoriaMansao;    // Vetor de salas compactas
+    MemoriaEstrutura memoriaRotas;     // Índice de rotas (pais, profundidades e ancestral comum)
+    MemoriaEstrutura memoriaIndices;   // Índices por texto (sala pelo nome, salas de cada pista)
+};
+
+// Fases medidas pelos cronômetros
+typedef enum Fase {
+    FASE_CARREGAR_CASO,   // carregarCaso inteiro (leitura do arquivo)
+    FASE_CRIAR_SALA,      // Cada criarSala do caso padrão
+    FASE_INSERIR_HASH,    // Cada inserirNaHash
+    FASE_CONGELAR,        // congelarCaso
+    FASE_COMANDO,         // Cada passo de explorarSalas (sem a espera pelo comando)
+    FASE_JULGAMENTO,      // verificarSuspeitoFinal (inclui ler a acusação)
+    FASE_SESSAO,          // Uma sessão inteira do modo roteiro
+    TOTAL_FASES
+} Fase;
+
+// Histograma log-linear: cada potência de dois é dividida em SUBFAIXAS_LATENCIA
+// faixas, então p50/p99 saem com erro relativo de no máximo 1/16 (~6%).
+typedef struct HistogramaLatencia {
+    unsigned long long contagens[FAIXAS_LATENCIA];
+    unsigned long long quantidade;
+    unsigned long long totalNs;
+    uint64_t maximoNs;
+} HistogramaLatencia;
+
+// Um intervalo medido, para o trace do Chrome/Perfetto
+typedef struct EventoTrace {
+    uint64_t inicioNs;
+    uint64_t duracaoNs;
+    Fase fase;
+} EventoTrace;
+
+// Estado global da medição de latência (desligada por padrão)
+typedef struct Medicao {
+    int ativa;                       // 1 = os cronômetros leem o relógio
+    uint64_t origemNs;               // Instante em que a medição foi ligada
+    HistogramaLatencia fases[TOTAL_FASES];
+    EventoTrace *eventos;            // NULL = sem trace
+    unsigned int numEventos;
+    unsigned int capacidadeEventos;
+    unsigned long long eventosDescartados;
+} Medicao;
+
+// Redução paralela das evidências: as pistas achatadas num vetor são divididas
+// em lotes; cada trabalhador pega o próximo lote livre com um contador atômico
+// e conta num vetor próprio, somado aos demais no final.
+typedef struct ReducaoEvidencias {
+    const IdTexto *pistas;       // Pistas coletadas, em ordem alfabética
+    size_t quantidade;
+    TabelaHash *tabela;          // Só lida durante a redução
+    atomic_size_t proximoLote;   // Índice da primeira pista ainda não distribuída
+} ReducaoEvidencias;
+
+// Modo servidor: um caso congelado compartilhado por um grupo fixo de trabalhadores
+typedef struct Servidor {
+    Caso *caso;                  // Somente leitura enquanto o servidor roda
+    int socketEscuta;
+    atomic_int encerrando;       // 1 depois do pedido de parada
+    atomic_ulong conexoes;
+    atomic_ulong sessoes;
+    pthread_mutex_t travaClientes;            // Protege clientes[] e o encerramento das conexões
+    int clientes[MAXIMO_TRABALHADORES];       // Conexão atendida por cada trabalhador (-1 = nenhuma)
+} Servidor;
+
+// Argumento de cada thread do servidor: o servidor e a vaga do trabalhador em clientes[]
+typedef struct TrabalhadorServidor {
+    Servidor *servidor;
+    unsigned int indice;
+} TrabalhadorServidor;
+
+// Conjunto de strings internadas compartilhado por mansão, pistas e tabela hash
+static TabelaInterna internos;
+
+// Nível de log atual (NIVEL_SILENCIOSO, NIVEL_INFO ou NIVEL_DEPURACAO)
+static int nivelLog = NIVEL_INFO;
+
+// Cronômetros das fases (--tempos / --trace)
+static Medicao medicao;
+
+// Contadores do filtro de Bloom desta thread e os totais já recolhidos
+static _Thread_local ContadoresFiltro contadoresFiltro;
+static ContadoresFiltro totaisFiltro;
+static pthread_mutex_t travaFiltro = PTHREAD_MUTEX_INITIALIZER;
+
+
+// --- 2. FUNÇÕES DE SUPORTE ---
+
+/**
+ * Converte o nome de um nível de log ("silencioso", "info" ou "depuracao").
+ * Retorna o nível, ou -1 se o nome for desconhecido.
+ */
+int nivelDoNome(const char *nome) {
+    static const char *const nomes[] = { "silencioso", "info", "depuracao" };
+    for (int nivel = NIVEL_SILENCIOSO; nivel <= NIVEL_DEPURACAO; nivel++) {
+        if (strcmp(nome, nomes[nivel]) == 0) {
+            return nivel;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Define o nível de log e troca o buffer de stdout por um bloco grande: a
+ * saída só é escrita quando o buffer enche ou antes de esperar o jogador
+ * (lerComando descarrega). Deve ser chamada antes de qualquer escrita em stdout.
+ */
+void configurarLog(int nivel) {
+    nivelLog = nivel;
+    setvbuf(stdout, NULL, _IOFBF, TAMANHO_BUFFER_SAIDA);
+}
+
+// Nomes das fases como aparecem no relatório e no trace
+static const char *const NOMES_FASES[TOTAL_FASES] = {
+    "carregarCaso", "criarSala", "inserirNaHash", "congelarCaso",
+    "explorarSalas.comando", "verificarSuspeitoFinal", "sessao"
+};
+
+// Relógio monotônico em nanossegundos
+static uint64_t relogioNs(void) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (uint64_t)agora.tv_sec * 1000000000ull + (uint64_t)agora.tv_nsec;
+}
+
+/**
+ * Liga os cronômetros. Com 'comTrace', cada intervalo também é guardado
+ * (até MAXIMO_EVENTOS_TRACE) para salvarTrace.
+ */
+void ativarMedicao(int comTrace) {
+    memset(&medicao, 0, sizeof(medicao));
+    medicao.ativa = 1;
+    medicao.origemNs = relogioNs();
+    if (comTrace) {
+        medicao.capacidadeEventos = 1024;
+        medicao.eventos = (EventoTrace*)malloc(medicao.capacidadeEventos * sizeof(EventoTrace));
+        if (medicao.eventos == NULL) {
+            perror("Erro de alocação de memória para o trace");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Faixa do histograma de uma duração: exata abaixo de 64 ns, log-linear acima
+static unsigned int faixaLatencia(uint64_t ns) {
+    if (ns < 64) {
+        return (unsigned int)ns;
+    }
+    unsigned int expoente = 63 - (unsigned int)__builtin_clzll(ns); // >= 6
+    unsigned int subfaixa = (unsigned int)(ns >> (expoente - 4)) & (SUBFAIXAS_LATENCIA - 1);
+    return 64 + (expoente - 6) * SUBFAIXAS_LATENCIA + subfaixa;
+}
+
+// Maior duração que cai numa faixa (o percentil é arredondado para cima)
+static uint64_t limiteDaFaixa(unsigned int faixa) {
+    if (faixa < 64) {
+        return faixa;
+    }
+    unsigned int expoente = 6 + (faixa - 64) / SUBFAIXAS_LATENCIA;
+    uint64_t subfaixa = (faixa - 64) % SUBFAIXAS_LATENCIA;
+    uint64_t largura = 1ull << (expoente - 4);
+    return (1ull << expoente) + (subfaixa + 1) * largura - 1;
+}
+
+// Fecha o intervalo de uma fase iniciado em 'inicioNs' (chamada por TERMINAR_MEDIDA)
+static void registrarMedida(Fase fase, uint64_t inicioNs) {
+    uint64_t duracao = relogioNs() - inicioNs;
+    HistogramaLatencia *histograma = &medicao.fases[fase];
+    histograma->contagens[faixaLatencia(duracao)]++;
+    histograma->quantidade++;
+    histograma->totalNs += duracao;
+    if (duracao > histograma->maximoNs) {
+        histograma->maximoNs = duracao;
+    }
+
+    if (medicao.eventos != NULL) {
+        if (medicao.numEventos == medicao.capacidadeEventos) {
+            if (medicao.capacidadeEventos >= MAXIMO_EVENTOS_TRACE) {
+                medicao.eventosDescartados++;
+                return;
+            }
+            medicao.capacidadeEventos *= 2;
+            medicao.eventos = (EventoTrace*)realloc(medicao.eventos, medicao.capacidadeEventos * sizeof(EventoTrace));
+            if (medicao.eventos == NULL) {
+                perror("Erro de alocação de memória para o trace");
+                exit(EXIT_FAILURE);
+            }
+        }
+        EventoTrace *evento = &medicao.eventos[medicao.numEventos++];
+        evento->inicioNs = inicioNs - medicao.origemNs;
+        evento->duracaoNs = duracao;
+        evento->fase = fase;
+    }
+}
+
+// Menor duração abaixo da qual está a fração 'percentil' (0..1) das medidas
+static uint64_t percentilLatencia(const HistogramaLatencia *histograma, double percentil) {
+    if (histograma->quantidade == 0) {
+        return 0;
+    }
+    unsigned long long alvo = (unsigned long long)(percentil * (double)histograma->quantidade);
+    if (alvo == 0) {
+        alvo = 1;
+    }
+    unsigned long long acumulado = 0;
+    for (unsigned int i = 0; i < FAIXAS_LATENCIA; i++) {
+        acumulado += histograma->contagens[i];
+        if (acumulado >= alvo) {
+            uint64_t limite = limiteDaFaixa(i);
+            return limite < histograma->maximoNs ? limite : histograma->maximoNs;
+        }
+    }
+    return histograma->maximoNs;
+}
+
+// Imprime contagem, média, p50, p99 e máximo de cada fase que foi medida
+void imprimirLatencias(FILE *saida) {
+    fprintf(saida, "\n=============== LATÊNCIAS (ns) ===============\n");
+    fprintf(saida, "%-24s %10s %10s %10s %10s %10s\n", "fase", "vezes", "média", "p50", "p99", "máximo");
+    for (int fase = 0; fase < TOTAL_FASES; fase++) {
+        const HistogramaLatencia *histograma = &medicao.fases[fase];
+        if (histograma->quantidade == 0) {
+            continue;
+        }
+        fprintf(saida, "%-24s %10llu %10llu %10llu %10llu %10llu\n", NOMES_FASES[fase],
+                histograma->quantidade, histograma->totalNs / histograma->quantidade,
+                (unsigned long long)percentilLatencia(histograma, 0.50),
+                (unsigned long long)percentilLatencia(histograma, 0.99),
+                (unsigned long long)histograma->maximoNs);
+    }
+    if (medicao.eventosDescartados > 0) {
+        fprintf(saida, "(trace cheio: %llu evento(s) descartado(s))\n", medicao.eventosDescartados);
+    }
+}
+
+/**
+ * Grava os intervalos guardados no formato JSON de trace do Chrome
+ * (abre em chrome://tracing ou ui.perfetto.dev). Tempos em microssegundos.
+ * Retorna 0 em caso de sucesso ou -1 em caso de erro.
+ */
+int salvarTrace(const char *caminho) {
+    FILE *arquivo = fopen(caminho, "w");
+    if (arquivo == NULL) {
+        perror(caminho);
+        return -1;
+    }
+    fprintf(arquivo, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (unsigned int i = 0; i < medicao.numEventos; i++) {
+        const EventoTrace *evento = &medicao.eventos[i];
+        fprintf(arquivo, "{\"name\":\"%s\",\"cat\":\"detective\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                         "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}%s\n",
+                NOMES_FASES[evento->fase],
+                (unsigned long long)(evento->inicioNs / 1000), (unsigned long long)(evento->inicioNs % 1000),
+                (unsigned long long)(evento->duracaoNs / 1000), (unsigned long long)(evento->duracaoNs % 1000),
+                i + 1 < medicao.numEventos ? "," : "");
+    }
+    fprintf(arquivo, "]}\n");
+    if (fclose(arquivo) != 0) {
+        perror(caminho);
+        return -1;
+    }
+    return 0;
+}
+
+// Desliga a medição e libera os eventos do trace
+void encerrarMedicao(void) {
+    free(medicao.eventos);
+    memset(&medicao, 0, sizeof(medicao));
+}
+
+/**
+ * Reserva 'tamanho' bytes na arena. Quando o bloco atual acaba, um novo bloco
+ * é encadeado; pedidos maiores que um bloco ganham um bloco do tamanho exato.
+ * Retorna um ponteiro alinhado para a memória reservada.
+ */
+static void* alocarNaArena(Arena *arena, size_t tamanho) {
+    tamanho = (tamanho + ALINHAMENTO_ARENA - 1) & ~(size_t)(ALINHAMENTO_ARENA - 1);
+    BlocoArena *bloco = arena->atual;
+
+    if (bloco == NULL || bloco->usado + tamanho > bloco->capacidade) {
+        size_t capacidade = tamanho > TAMANHO_BLOCO_ARENA ? tamanho : TAMANHO_BLOCO_ARENA;
+        BlocoArena *novoBloco = (BlocoArena*)malloc(sizeof(BlocoArena) + capacidade);
+        if (novoBloco == NULL) {
+            perror("Erro de alocação de memória para Arena");
+            exit(EXIT_FAILURE);
+        }
+        novoBloco->anterior = bloco;
+        novoBloco->usado = 0;
+        novoBloco->capacidade = capacidade;
+        arena->atual = novoBloco;
+        bloco = novoBloco;
+    }
+
+    void *memoria = bloco->dados + bloco->usado;
+    bloco->usado += tamanho;
+    return memoria;
+}
+
+// Registra a posição atual da arena
+static MarcaArena marcarArena(Arena *arena) {
+    MarcaArena marca;
+    marca.bloco = arena->atual;
+    marca.usado = arena->atual != NULL ? arena->atual->usado : 0;
+    return marca;
+}
+
+// Devolve à arena tudo o que foi alocado depois da marca (blocos novos são liberados)
+static void restaurarArena(Arena *arena, MarcaArena marca) {
+    while (arena->atual != marca.bloco) {
+        BlocoArena *anterior = arena->atual->anterior;
+        free(arena->atual);
+        arena->atual = anterior;
+    }
+    if (arena->atual != NULL) {
+        arena->atual->usado = marca.usado;
+    }
+}
+
+// Libera todos os blocos da arena de uma só vez
+static void liberarArena(Arena *arena) {
+    BlocoArena *bloco = arena->atual;
+    while (bloco != NULL) {
+        BlocoArena *anterior = bloco->anterior;
+        free(bloco);
+        bloco = anterior;
+    }
+    arena->atual = NULL;
+}
+
+// Hash polinomial original (hashVal * 31 + c): barato, mas agrupa chaves parecidas
+static unsigned int hashPolinomial(const char *chave, size_t tamanho) {
+    unsigned int hashVal = 0;
+    for (size_t i = 0; i < tamanho; i++) {
+        hashVal = hashVal * 31 + chave[i];
+    }
+    return hashVal;
+}
+
+// FNV-1a de 32 bits: um byte por vez, boa dispersão para chaves curtas
+static unsigned int hashFnv1a(const char *chave, size_t tamanho) {
+    unsigned int hashVal = 2166136261u;
+    for (size_t i = 0; i < tamanho; i++) {
+        hashVal = (hashVal ^ (unsigned char)chave[i]) * 16777619u;
+    }
+    return hashVal;
+}
+
+static uint64_t rotacionar64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Embaralhamento final do MurmurHash3: cada bit de entrada afeta todos os de saída
+static uint64_t finalizar64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Hash rápido não criptográfico de 64 bits: consome a chave 8 bytes por vez
+ * (leituras sem alinhamento via memcpy) e mistura cada bloco com multiplicações
+ * e rotações. A semente escolhe outra função da mesma família.
+ * O valor depende da ordem de bytes da máquina.
+ */
+static uint64_t hashRapido64(const char *chave, size_t tamanho, uint64_t semente) {
+    const unsigned char *p = (const unsigned char*)chave;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ semente ^ ((uint64_t)tamanho * 0xC2B2AE3D27D4EB4FULL);
+
+    while (tamanho >= 8) {
+        uint64_t bloco;
+        memcpy(&bloco, p, 8);
+        h ^= rotacionar64(bloco * 0x87C37B91114253D5ULL, 31) * 0x4CF5AD432745937FULL;
+        h = rotacionar64(h, 27) * 5 + 0x52DCE729;
+        p += 8;
+        tamanho -= 8;
+    }
+    if (tamanho > 0) {
+        // Resto de 1 a 7 bytes sem laço: duas leituras de 4 bytes que se sobrepõem,
+        // ou o primeiro, o do meio e o último byte quando há menos de 4
+        uint64_t resto;
+        if (tamanho >= 4) {
+            uint32_t inicio, fim;
+            memcpy(&inicio, p, 4);
+            memcpy(&fim, p + tamanho - 4, 4);
+            resto = ((uint64_t)inicio << 32) | fim;
+        } else {
+            resto = ((uint64_t)p[0] << 16) | ((uint64_t)p[tamanho / 2] << 8) | p[tamanho - 1];
+        }
+        h ^= rotacionar64(resto * 0x87C37B91114253D5ULL, 31) * 0x4CF5AD432745937FULL;
+    }
+    return finalizar64(h);
+}
+
+// hashRapido64 dobrado para 32 bits (não é gravado em nenhum arquivo)
+static unsigned int hashRapido(const char *chave, size_t tamanho) {
+    uint64_t h = hashRapido64(chave, tamanho, 0);
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+// Balde de uma chave no hash perfeito: redução por multiplicação dos 32 bits baixos
+static uint32_t baldePerfeito(uint64_t h, uint32_t numBaldes) {
+    return (uint32_t)(((h & 0xFFFFFFFFu) * numBaldes) >> 32);
+}
+
+// Posição final de uma chave: o piloto do balde escolhe outro embaralhamento do hash
+static uint32_t posicaoPerfeita(uint64_t h, uint32_t piloto, uint32_t quantidade) {
+    uint64_t misturado = finalizar64(h ^ ((uint64_t)(piloto + 1) * 0x9E3779B97F4A7C15ULL));
+    return (uint32_t)(((misturado >> 32) * quantidade) >> 32);
+}
+
+// Função de hash em uso por todo o programa (internados e tabela de associações)
+static FuncaoHash funcaoHash = HASH_PADRAO;
+
+/**
+ * Escolhe a função de hash pelo nome: "rapido", "fnv1a" ou "polinomial".
+ * Só pode ser chamada antes de internar qualquer texto, pois os hashes guardados
+ * deixariam de valer. Retorna 1 se a troca foi feita e 0 caso contrário.
+ */
+int selecionarHash(const char *nome) {
+    static const struct { const char *nome; FuncaoHash funcao; } opcoes[] = {
+        { "rapido", hashRapido },
+        { "fnv1a", hashFnv1a },
+        { "polinomial", hashPolinomial },
+    };
+    if (internos.quantidade != 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(opcoes) / sizeof(opcoes[0]); i++) {
+        if (strcmp(nome, opcoes[i].nome) == 0) {
+            funcaoHash = opcoes[i].funcao;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Hash dos primeiros 'tamanho' bytes da chave com a função selecionada.
+// Retorna o valor completo; o índice é obtido com a máscara da capacidade atual.
+static unsigned int hashN(const char *chave, size_t tamanho) {
+    return funcaoHash(chave, tamanho);
+}
+
+static inline unsigned int hash(const char *chave) {
+    return hashN(chave, strlen(chave));
+}
+
+// Letras acentuadas do Latin-1 (segundo byte de U+00C0..U+00FF em UTF-8, menos 0x80)
+// dobradas para a letra minúscula sem acento; 0 = mantém os dois bytes como estão.
+static const char DOBRA_ACENTOS[64] = {
+    'a', 'a', 'a', 'a', 'a', 'a', 0, 'c', 'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i', // À..Ï
+    0, 'n', 'o', 'o', 'o', 'o', 'o', 0, 'o', 'u', 'u', 'u', 'u', 'y', 0, 0,         // Ð..ß
+    'a', 'a', 'a', 'a', 'a', 'a', 0, 'c', 'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i', // à..ï
+    0, 'n', 'o', 'o', 'o', 'o', 'o', 0, 'o', 'u', 'u', 'u', 'u', 'y', 0, 'y'        // ð..ÿ
+};
+
+static int ehEspaco(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+/**
+ * Normaliza um texto para uso como chave de busca: remove os espaços das pontas,
+ * reduz cada sequência de espaços internos a um só, passa para minúsculas e
+ * tira os acentos do português (UTF-8). " Fogão  Sujo" e "fogao sujo" viram a mesma chave.
+ * A saída nunca é maior que a entrada, então 'saida' precisa de 'tamanho' bytes.
+ * Retorna o tamanho da chave (sem terminador).
+ */
+static size_t normalizarChave(const char *texto, size_t tamanho, char *saida) {
+    const unsigned char *p = (const unsigned char*)texto;
+    size_t inicio = 0;
+    while (inicio < tamanho && ehEspaco(p[inicio])) {
+        inicio++;
+    }
+    while (tamanho > inicio && ehEspaco(p[tamanho - 1])) {
+        tamanho--;
+    }
+
+    size_t n = 0;
+    for (size_t i = inicio; i < tamanho; i++) {
+        unsigned char c = p[i];
+        if (ehEspaco(c)) {
+            if (saida[n - 1] != ' ') {
+                saida[n++] = ' '; // Nunca é o primeiro byte: as pontas já foram aparadas
+            }
+        } else if (c >= 'A' && c <= 'Z') {
+            saida[n++] = (char)(c - 'A' + 'a');
+        } else if (c == 0xC3 && i + 1 < tamanho && p[i + 1] >= 0x80 && p[i + 1] <= 0xBF &&
+                   DOBRA_ACENTOS[p[i + 1] - 0x80] != 0) {
+            saida[n++] = DOBRA_ACENTOS[p[i + 1] - 0x80];
+            i++;
+        } else {
+            saida[n++] = (char)c;
+        }
+    }
+    return n;
+}
+
+// Retorna o texto de um id internado
+static const char* textoDoId(IdTexto id) {
+    return internos.blob + internos.deslocamentos[id];
+}
+
+// Retorna o tamanho (sem terminador) do texto de um id internado
+static size_t tamanhoDoId(IdTexto id) {
+    size_t fim = id + 1 < internos.quantidade ? internos.deslocamentos[id + 1] : internos.tamanhoBlob;
+    return fim - internos.deslocamentos[id] - 1;
+}
+
+// Retorna o hash já calculado do texto de um id internado
+static unsigned int hashDoTexto(IdTexto id) {
+    return internos.hashes[id];
+}
+
+// Retorna o id da chave normalizada de um texto internado (a chave de uma chave é ela mesma)
+static IdTexto chaveDoId(IdTexto id) {
+    return internos.chaves[id];
+}
+
+// Grava um id na tabela de posições (o id ainda não pode estar presente)
+static void posicionarInterno(IdTexto id) {
+    unsigned int mascara = internos.capacidadePosicoes - 1;
+    unsigned int indice = internos.hashes[id] & mascara;
+    while (internos.posicoes[indice] != 0) {
+        indice = (indice + 1) & mascara;
+    }
+    internos.posicoes[indice] = id + 1;
+}
+
+/**
+ * Procura uma string no conjunto de internados sem inseri-la.
+ * Compara o hash guardado antes de tocar nos bytes da string.
+ * Retorna o id, ou TEXTO_INEXISTENTE se o texto nunca foi internado.
+ */
+static IdTexto buscarTextoN(const char *texto, size_t tamanho, unsigned int h) {
+    if (internos.capacidadePosicoes == 0) {
+        return TEXTO_INEXISTENTE;
+    }
+    unsigned int mascara = internos.capacidadePosicoes - 1;
+    unsigned int indice = h & mascara;
+    while (internos.posicoes[indice] != 0) {
+        IdTexto id = internos.posicoes[indice] - 1;
+        const char *candidato = textoDoId(id);
+        if (internos.hashes[id] == h && strncmp(candidato, texto, tamanho) == 0 && candidato[tamanho] == '\0') {
+            return id;
+        }
+        indice = (indice + 1) & mascara;
+    }
+    return TEXTO_INEXISTENTE;
+}
+
+static inline IdTexto buscarTexto(const char *texto) {
+    size_t tamanho = strlen(texto);
+    return buscarTextoN(texto, tamanho, hashN(texto, tamanho));
+}
+
+/**
+ * Procura a chave normalizada de um texto digitado ou lido, sem internar nada.
+ * Retorna o id da chave, ou TEXTO_INEXISTENTE se nenhum texto internado tem essa chave.
+ */
+static IdTexto buscarChave(const char *texto) {
+    size_t tamanho = strlen(texto);
+    char local[TAMANHO_LINHA_COMANDO];
+    char *chave = tamanho <= sizeof(local) ? local : (char*)malloc(tamanho);
+    if (chave == NULL) {
+        perror("Erro de alocação de memória para a chave normalizada");
+        exit(EXIT_FAILURE);
+    }
+    size_t tamanhoChave = normalizarChave(texto, tamanho, chave);
+    IdTexto id = buscarTextoN(chave, tamanhoChave, hashN(chave, tamanhoChave));
+    if (chave != local) {
+        free(chave);
+    }
+    return id;
+}
+
+/**
+ * Interna os 'tamanho' primeiros bytes de um texto.
+ * Na primeira chamada o conjunto é criado e o id 0 fica reservado para "".
+ * A chave normalizada de cada texto novo é calculada (e internada) uma única vez aqui.
+ * Retorna o id do texto (o mesmo id para textos iguais).
+ */
+static IdTexto internarTextoN(const char *texto, size_t tamanho) {
+    if (internos.capacidadePosicoes == 0) {
+        internos.capacidadePosicoes = TAMANHO_INICIAL_INTERNOS * 2;
+        internos.posicoes = (IdTexto*)calloc(internos.capacidadePosicoes, sizeof(IdTexto));
+        internos.capacidadeIds = TAMANHO_INICIAL_INTERNOS;
+        internos.deslocamentos = (size_t*)malloc(internos.capacidadeIds * sizeof(size_t));
+        internos.hashes = (unsigned int*)malloc(internos.capacidadeIds * sizeof(unsigned int));
+        internos.chaves = (IdTexto*)malloc(internos.capacidadeIds * sizeof(IdTexto));
+        internos.capacidadeBlob = TAMANHO_INICIAL_INTERNOS * 16;
+        internos.blob = (char*)malloc(internos.capacidadeBlob);
+        if (internos.posicoes == NULL || internos.deslocamentos == NULL || internos.hashes == NULL ||
+            internos.chaves == NULL || internos.blob == NULL) {
+            perror("Erro de alocação de memória para TabelaInterna");
+            exit(EXIT_FAILURE);
+        }
+        internos.tamanhoBlob = 0;
+        internos.quantidade = 0;
+        internarTextoN("", 0); // Recebe o id TEXTO_VAZIO
+    }
+
+    unsigned int h = hashN(texto, tamanho);
+    IdTexto existente = buscarTextoN(texto, tamanho, h);
+    if (existente != TEXTO_INEXISTENTE) {
+        return existente;
+    }
+
+    // Interna antes a forma normalizada, se for diferente do próprio texto
+    char local[TAMANHO_LINHA_COMANDO];
+    char *normalizado = tamanho <= sizeof(local) ? local : (char*)malloc(tamanho);
+    if (normalizado == NULL) {
+        perror("Erro de alocação de memória para a chave normalizada");
+        exit(EXIT_FAILURE);
+    }
+    size_t tamanhoNormalizado = normalizarChave(texto, tamanho, normalizado);
+    IdTexto chave = TEXTO_INEXISTENTE; // O próprio texto já é a chave
+    if (tamanhoNormalizado != tamanho || memcmp(normalizado, texto, tamanho) != 0) {
+        chave = internarTextoN(normalizado, tamanhoNormalizado);
+    }
+    if (normalizado != local) {
+        free(normalizado);
+    }
+
+    // Garante espaço no blob e nos vetores indexados por id
+    while (internos.tamanhoBlob + tamanho + 1 > internos.capacidadeBlob) {
+        internos.capacidadeBlob *= 2;
+        internos.blob = (char*)realloc(internos.blob, internos.capacidadeBlob);
+        if (internos.blob == NULL) {
+            perror("Erro de alocação de memória para TabelaInterna");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (internos.quantidade == internos.capacidadeIds) {
+        internos.capacidadeIds *= 2;
+        internos.deslocamentos = (size_t*)realloc(internos.deslocamentos, internos.capacidadeIds * sizeof(size_t));
+        internos.hashes = (unsigned int*)realloc(internos.hashes, internos.capacidadeIds * sizeof(unsigned int));
+        internos.chaves = (IdTexto*)realloc(internos.chaves, internos.capacidadeIds * sizeof(IdTexto));
+        if (internos.deslocamentos == NULL || internos.hashes == NULL || internos.chaves == NULL) {
+            perror("Erro de alocação de memória para TabelaInterna");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    IdTexto id = internos.quantidade++;
+    memcpy(internos.blob + internos.tamanhoBlob, texto, tamanho);
+    internos.blob[internos.tamanhoBlob + tamanho] = '\0';
+    internos.deslocamentos[id] = internos.tamanhoBlob;
+    internos.hashes[id] = h;
+    internos.chaves[id] = chave != TEXTO_INEXISTENTE ? chave : id;
+    internos.tamanhoBlob += tamanho + 1;
+
+    // Mantém a tabela de posições com no máximo metade de ocupação
+    if (internos.quantidade * 2 > internos.capacidadePosicoes) {
+        free(internos.posicoes);
+        internos.capacidadePosicoes *= 2;
+        internos.posicoes = (IdTexto*)calloc(internos.capacidadePosicoes, sizeof(IdTexto));
+        if (internos.posicoes == NULL) {
+            perror("Erro de alocação de memória para TabelaInterna");
+            exit(EXIT_FAILURE);
+        }
+        for (IdTexto i = 0; i < internos.quantidade; i++) {
+            posicionarInterno(i);
+        }
+    } else {
+        posicionarInterno(id);
+    }
+    return id;
+}
+
+static IdTexto internarTexto(const char *texto) {
+    return internarTextoN(texto, strlen(texto));
+}
+
+// Libera o conjunto de strings internadas (invalida todos os ids)
+void liberarInternos(void) {
+    free(internos.blob);
+    free(internos.deslocamentos);
+    free(internos.hashes);
+    free(internos.chaves);
+    free(internos.posicoes);
+    memset(&internos, 0, sizeof(internos));
+}
+
+// Aloca um cômodo na arena a partir de textos já internados (sem mensagens)
+static NoSala* novaSala(Arena *arena, IdTexto nome, IdTexto pista) {
+    NoSala *sala = (NoSala*)alocarNaArena(arena, sizeof(NoSala));
+    sala->nome = nome;
+    sala->pista = pista;
+    sala->esquerda = NULL;
+    sala->direita = NULL;
+    return sala;
+}
+
+/**
+ *  Criar dinamicamente um novo cômodo (nó de sala) na mansão.
+ *  A arena do caso, de onde o nó é alocado.
+ *  O nome exclusivo do cômodo.
+ *  A pista estática associada a este cômodo.
+ *  Um ponteiro para a nova estrutura NoSala alocada.
+ */
+static NoSala* criarSala(Arena *arena, const char *nome, const char *pista) {
+    uint64_t inicio = INICIAR_MEDIDA();
+    NoSala *sala = novaSala(arena, internarTexto(nome), internarTexto(pista));
+    DEPURACAO("> Cômodo '%s' (Pista: '%s') criado.\n", nome, pista);
+    TERMINAR_MEDIDA(FASE_CRIAR_SALA, inicio);
+    return sala;
+}
+
+// Primeiros 4 bytes de uma chave como inteiro big-endian (completados com zeros):
+// comparar prefixos dá a mesma ordem que strcmp nesses bytes
+static uint32_t prefixoDaChave(IdTexto chave) {
+    const unsigned char *texto = (const unsigned char*)textoDoId(chave);
+    uint32_t prefixo = 0;
+    int fim = 0;
+    for (int i = 0; i < 4; i++) {
+        fim = fim || texto[i] == '\0';
+        prefixo = (prefixo << 8) | (fim ? 0 : texto[i]);
+    }
+    return prefixo;
+}
+
+// Ordem da árvore de pistas: 1 se a chave 'a' vem antes de 'b' (prefixo e, no empate, strcmp)
+static int chaveVemAntes(IdTexto a, IdTexto b) {
+    uint32_t prefixoA = prefixoDaChave(a), prefixoB = prefixoDaChave(b);
+    return prefixoA != prefixoB ? prefixoA < prefixoB : strcmp(textoDoId(a), textoDoId(b)) < 0;
+}
+
+// Altura de uma subárvore de pistas (árvore vazia = 0)
+static int alturaPista(NoPista *no) {
+    return no != NULL ? no->altura : 0;
+}
+
+// Recalcula a altura de um nó a partir das alturas dos filhos
+static void atualizarAltura(NoPista *no) {
+    int alturaEsquerda = alturaPista(no->esquerda);
+    int alturaDireita = alturaPista(no->direita);
+    no->altura = 1 + (alturaEsquerda > alturaDireita ? alturaEsquerda : alturaDireita);
+}
+
+static NoPista* rotacionarDireita(NoPista *no) {
+    NoPista *filho = no->esquerda;
+    no->esquerda = filho->direita;
+    filho->direita = no;
+    atualizarAltura(no);
+    atualizarAltura(filho);
+    return filho;
+}
+
+static NoPista* rotacionarEsquerda(NoPista *no) {
+    NoPista *filho = no->direita;
+    no->direita = filho->esquerda;
+    filho->esquerda = no;
+    atualizarAltura(no);
+    atualizarAltura(filho);
+    return filho;
+}
+
+/**
+ * Restaura o balanceamento AVL de um nó cujos filhos já estão balanceados.
+ * Retorna a nova raiz da subárvore.
+ */
+static NoPista* balancearPista(NoPista *no) {
+    atualizarAltura(no);
+    int fator = alturaPista(no->esquerda) - alturaPista(no->direita);
+
+    if (fator > 1) {
+        if (alturaPista(no->esquerda->esquerda) < alturaPista(no->esquerda->direita)) {
+            no->esquerda = rotacionarEsquerda(no->esquerda); // Caso esquerda-direita
+        }
+        return rotacionarDireita(no);
+    }
+    if (fator < -1) {
+        if (alturaPista(no->direita->direita) < alturaPista(no->direita->esquerda)) {
+            no->direita = rotacionarDireita(no->direita); // Caso direita-esquerda
+        }
+        return rotacionarEsquerda(no);
+    }
+    return no;
+}
+
+/**
+ * Inserir a pista coletada na Árvore AVL de forma ordenada.
+ * A descida é iterativa e guarda o caminho percorrido; na volta, apenas os
+ * nós desse caminho são rebalanceados, então a altura fica sempre O(log n).
+ * Pistas repetidas são detectadas pela igualdade dos ids das chaves normalizadas
+ * (" Fogao sujo" e "Fogão sujo" são a mesma pista). Para decidir o lado, compara
+ * primeiro o prefixo guardado no nó e só desce às strings quando os prefixos empatam
+ * (a ordem continua alfabética, pela chave).
+ * A arena de onde o novo nó é alocado.
+ * O nó raiz da árvore de pistas.
+ * O id internado da pista a ser inserida.
+ * Inserida, recebe 1 se a pista era nova e 0 se já existia (pode ser NULL).
+ * O novo nó raiz da árvore de pistas.
+ */
+static NoPista* inserirPista(Arena *arena, NoPista *raiz, IdTexto novaPista, int *inserida) {
+    NoPista **caminho[ALTURA_MAXIMA_AVL];
+    int profundidade = 0;
+    NoPista **ligacao = &raiz;
+    IdTexto chave = chaveDoId(novaPista);
+    uint32_t prefixo = prefixoDaChave(chave);
+
+    while (*ligacao != NULL) {
+        NoPista *no = *ligacao;
+        if (chave == no->chave) {
+            // Ignora se a pista já existe
+            if (inserida != NULL) *inserida = 0;
+            return raiz;
+        }
+        int menor = prefixo != no->prefixo ? prefixo < no->prefixo
+                                            : strcmp(textoDoId(chave), textoDoId(no->chave)) < 0;
+        caminho[profundidade++] = ligacao;
+        ligacao = menor ? &no->esquerda : &no->direita;
+    }
+
+    NoPista *novoNo = (NoPista*)alocarNaArena(arena, sizeof(NoPista));
+    novoNo->pista = novaPista;
+    novoNo->chave = chave;
+    novoNo->prefixo = prefixo;
+    novoNo->altura = 1;
+    novoNo->esquerda = NULL;
+    novoNo->direita = NULL;
+    *ligacao = novoNo;
+    if (inserida != NULL) *inserida = 1;
+
+    // Sobe pelo caminho rebalanceando; para quando a altura deixa de mudar
+    while (profundidade > 0) {
+        NoPista **ancestral = caminho[--profundidade];
+        int alturaAnterior = (*ancestral)->altura;
+        *ancestral = balancearPista(*ancestral);
+        if ((*ancestral)->altura == alturaAnterior) {
+            break;
+        }
+    }
+
+    return raiz;
+}
+
+/**
+ * Monta uma AVL perfeitamente balanceada a partir de pistas já em ordem
+ * (a ordem do percurso em ordem, sem repetições). Cada pista vira um nó sem
+ * nenhuma comparação: o meio de cada faixa é a raiz da subárvore, e a altura
+ * de uma faixa com m pistas é o número de bits de m. Custa O(n).
+ * Os nós saem de um único bloco da arena; a pilha de faixas nunca passa da altura.
+ * Retorna a raiz (NULL se não houver pistas).
+ */
+static NoPista* montarPistasOrdenadas(Arena *arena, const IdTexto *pistas, size_t quantidade) {
+    struct { size_t inicio, fim; NoPista **destino; } pilha[ALTURA_MAXIMA_AVL + 1];
+    int topo = 0;
+    NoPista *raiz = NULL;
+    if (quantidade == 0) {
+        return NULL;
+    }
+    NoPista *nos = (NoPista*)alocarNaArena(arena, quantidade * sizeof(NoPista));
+
+    pilha[topo].inicio = 0;
+    pilha[topo].fim = quantidade;
+    pilha[topo].destino = &raiz;
+    topo++;
+    while (topo > 0) {
+        topo--;
+        size_t inicio = pilha[topo].inicio, fim = pilha[topo].fim;
+        NoPista **destino = pilha[topo].destino;
+        if (inicio == fim) {
+            *destino = NULL;
+            continue;
+        }
+        size_t meio = inicio + (fim - inicio) / 2;
+        NoPista *no = &nos[meio];
+        no->pista = pistas[meio];
+        no->chave = chaveDoId(pistas[meio]);
+        no->prefixo = prefixoDaChave(no->chave);
+        no->altura = 64 - __builtin_clzll((unsigned long long)(fim - inicio));
+        *destino = no;
+
+        // A esquerda fica no topo e é resolvida primeiro; a direita espera um nível acima
+        pilha[topo].inicio = meio + 1;
+        pilha[topo].fim = fim;
+        pilha[topo].destino = &no->direita;
+        topo++;
+        pilha[topo].inicio = inicio;
+        pilha[topo].fim = meio;
+        pilha[topo].destino = &no->esquerda;
+        topo++;
+    }
+    return raiz;
+}
+
+/**
+ * Prepara uma Tabela Hash vazia com a capacidade inicial.
+ * Tabela, O ponteiro para a TabelaHash a ser inicializada.
+ */
+static void inicializarHash(TabelaHash *tabela) {
+    tabela->itens = (HashItem*)calloc(TAMANHO_TABELA_HASH, sizeof(HashItem));
+    if (tabela->itens == NULL) {
+        perror("Erro de alocação de memória para TabelaHash");
+        exit(EXIT_FAILURE);
+    }
+    tabela->capacidade = TAMANHO_TABELA_HASH;
+    tabela->quantidade = 0;
+    tabela->suspeitos = NULL;
+    tabela->pistasDoSuspeito = NULL;
+    tabela->numSuspeitos = 0;
+    tabela->capacidadeSuspeitos = 0;
+    tabela->suspeitoDoTexto = NULL;
+    tabela->tamanhoSuspeitoDoTexto = 0;
+    tabela->pilotos = NULL;
+    tabela->numBaldes = 0;
+    tabela->semente = 0;
+    tabela->filtro = NULL;
+    tabela->blocosFiltro = 0;
+    tabela->funcoesFiltro = 0;
+}
+
+/**
+ * Posiciona um item no vetor usando Robin Hood: durante a sondagem linear,
+ * quem está mais longe da posição ideal toma o lugar de quem está mais perto.
+ * Não verifica duplicatas (o chamador já garantiu que a chave é nova).
+ * Retorna o índice onde o item recebido foi gravado.
+ */
+static unsigned int posicionarItem(HashItem *itens, unsigned int capacidade, HashItem item) {
+    unsigned int mascara = capacidade - 1;
+    unsigned int indice = item.hash & mascara;
+    unsigned int posicaoFinal = capacidade; // Ainda não definida
+    item.distancia = 1;
+
+    while (1) {
+        HashItem *atual = &itens[indice];
+        if (atual->distancia == 0) {
+            *atual = item;
+            return posicaoFinal == capacidade ? indice : posicaoFinal;
+        }
+        if (atual->distancia < item.distancia) {
+            // O item residente está mais perto de casa: troca de lugar com ele
+            HashItem residente = *atual;
+            *atual = item;
+            item = residente;
+            if (posicaoFinal == capacidade) {
+                posicaoFinal = indice;
+            }
+        }
+        indice = (indice + 1) & mascara;
+        item.distancia++;
+    }
+}
+
+/**
+ * Troca a capacidade da tabela e reposiciona todas as associações.
+ * Tabela, O ponteiro para a TabelaHash.
+ * A nova capacidade (potência de dois, maior que a quantidade atual).
+ */
+static void realocarHash(TabelaHash *tabela, unsigned int novaCapacidade) {
+    HashItem *novosItens = (HashItem*)calloc(novaCapacidade, sizeof(HashItem));
+    if (novosItens == NULL) {
+        perror("Erro de alocação de memória para TabelaHash");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned int i = 0; i < tabela->capacidade; i++) {
+        if (tabela->itens[i].distancia != 0) {
+            posicionarItem(novosItens, novaCapacidade, tabela->itens[i]);
+        }
+    }
+    free(tabela->itens);
+    tabela->itens = novosItens;
+    tabela->capacidade = novaCapacidade;
+}
+
+/**
+ * Volta do hash perfeito para a tabela Robin Hood (uma chave nova não teria
+ * posição). Os itens do layout perfeito têm distância 1 e são reposicionados.
+ */
+static void desfazerPerfeita(TabelaHash *tabela) {
+    unsigned int capacidade = TAMANHO_TABELA_HASH;
+    while ((unsigned long long)(tabela->quantidade + 1) * CARGA_MAXIMA_DEN > (unsigned long long)capacidade * CARGA_MAXIMA_NUM) {
+        capacidade *= 2;
+    }
+    for (unsigned int i = 0; i < tabela->capacidade; i++) {
+        tabela->itens[i].hash = hashDoTexto(tabela->itens[i].pista);
+    }
+    free(tabela->pilotos);
+    tabela->pilotos = NULL;
+    tabela->numBaldes = 0;
+    realocarHash(tabela, capacidade);
+}
+
+// Dobra a capacidade da tabela
+static void redimensionarHash(TabelaHash *tabela) {
+    realocarHash(tabela, tabela->capacidade * 2);
+}
+
+/**
+ * Garante capacidade para 'quantidade' associações sem novos redimensionamentos.
+ * Usado pelo carregador quando o arquivo informa o total de antemão; evita também
+ * o agrupamento que surge ao reinserir chaves na ordem das posições de outra tabela.
+ * Retorna 0, ou -1 (sem mexer na tabela) se a capacidade não caberia num unsigned int.
+ */
+static int reservarHash(TabelaHash *tabela, unsigned long long quantidade) {
+    unsigned long long capacidade = tabela->capacidade;
+    while (quantidade * CARGA_MAXIMA_DEN > capacidade * CARGA_MAXIMA_NUM) {
+        capacidade *= 2;
+        if (capacidade > UINT_MAX) {
+            return -1;
+        }
+    }
+    if (tabela->pilotos != NULL) {
+        desfazerPerfeita(tabela);
+    }
+    if (capacidade > tabela->capacidade) {
+        realocarHash(tabela, (unsigned int)capacidade);
+    }
+    return 0;
+}
+
+/**
+ * Bloco e bits de uma chave no filtro de Bloom, tirados do hash já guardado
+ * do texto (nenhuma string é lida): o bloco vem dos 32 bits baixos da mistura,
+ * e cada um dos k bits dentro dele, dos 9 bits altos de um passo de LCG
+ * (passos de hashing duplo num bloco de 512 se repetiam demais entre chaves).
+ * Marcar = 1 grava os bits; 0 só testa.
+ * Retorna 1 se todos os bits estavam (ou ficaram) ligados.
+ */
+static int bitsDoFiltro(const TabelaHash *tabela, unsigned int h, int marcar) {
+    uint64_t g = finalizar64(h);
+    uint64_t *bloco = tabela->filtro + (size_t)((((g & 0xFFFFFFFFu) * tabela->blocosFiltro) >> 32) * (BITS_BLOCO_FILTRO / 64));
+    uint64_t x = g ^ (g >> 29);
+    for (unsigned int i = 0; i < tabela->funcoesFiltro; i++) {
+        x = x * 0x5851F42D4C957F2DULL + 0x14057B7EF767814FULL;
+        uint32_t posicao = (uint32_t)(x >> 55); // 0 .. BITS_BLOCO_FILTRO - 1
+        if (marcar) {
+            bloco[posicao >> 6] |= 1ULL << (posicao & 63);
+        } else if (!(bloco[posicao >> 6] & (1ULL << (posicao & 63)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Taxa de falsos positivos esperada do filtro montado: média, sobre os blocos, de (ocupação do bloco)^k
+static double taxaEstimadaFiltro(const TabelaHash *tabela) {
+    double soma = 0.0;
+    for (uint32_t b = 0; b < tabela->blocosFiltro; b++) {
+        const uint64_t *bloco = tabela->filtro + (size_t)b * (BITS_BLOCO_FILTRO / 64);
+        unsigned int ligados = 0;
+        for (unsigned int w = 0; w < BITS_BLOCO_FILTRO / 64; w++) {
+            ligados += (unsigned int)__builtin_popcountll(bloco[w]);
+        }
+        double taxa = 1.0, ocupacao = (double)ligados / BITS_BLOCO_FILTRO;
+        for (unsigned int i = 0; i < tabela->funcoesFiltro; i++) {
+            taxa *= ocupacao;
+        }
+        soma += taxa;
+    }
+    return soma / tabela->blocosFiltro;
+}
+
+/**
+ * Monta o filtro de Bloom com as chaves atuais da tabela para a taxa de falsos
+ * positivos pedida. Parte do dimensionamento clássico (k = log2(1/taxa) e
+ * k / ln 2 bits por chave); como os blocos não enchem por igual, a taxa do
+ * filtro montado é estimada e ele cresce 1/8 até ficar dentro do pedido.
+ * Chaves associadas depois também entram no filtro (só a taxa piora).
+ * Taxa, entre 0 e 1 (exclusive).
+ */
+static void construirFiltro(TabelaHash *tabela, double taxa) {
+    // log2(1/taxa) dígito binário a dígito binário, para não depender da libm
+    double x = 1.0 / taxa, bitsPorChave = 0.0;
+    while (x >= 2.0) {
+        x /= 2.0;
+        bitsPorChave += 1.0;
+    }
+    for (double peso = 0.5; peso > 1e-6; peso /= 2.0) {
+        x *= x;
+        if (x >= 2.0) {
+            x /= 2.0;
+            bitsPorChave += peso;
+        }
+    }
+    unsigned int funcoes = (unsigned int)(bitsPorChave + 0.5);
+    bitsPorChave *= 1.4426950408889634; // 1 / ln 2
+
+    unsigned long long bits = (unsigned long long)(tabela->quantidade * bitsPorChave) + 1;
+    tabela->blocosFiltro = (uint32_t)((bits + BITS_BLOCO_FILTRO - 1) / BITS_BLOCO_FILTRO);
+    tabela->funcoesFiltro = funcoes > 0 ? funcoes : 1;
+    while (1) {
+        free(tabela->filtro);
+        tabela->filtro = (uint64_t*)calloc((size_t)tabela->blocosFiltro * (BITS_BLOCO_FILTRO / 64), sizeof(uint64_t));
+        if (tabela->filtro == NULL) {
+            perror("Erro de alocação de memória para o filtro de Bloom");
+            exit(EXIT_FAILURE);
+        }
+        for (unsigned int i = 0; i < tabela->capacidade; i++) {
+            if (tabela->itens[i].distancia != 0) {
+                bitsDoFiltro(tabela, hashDoTexto(tabela->itens[i].pista), 1);
+            }
+        }
+        if (taxaEstimadaFiltro(tabela) <= taxa) {
+            break;
+        }
+        tabela->blocosFiltro += tabela->blocosFiltro / 8 + 1;
+    }
+}
+
+// Soma os contadores do filtro desta thread nos totais e os zera
+static void recolherContadoresFiltro(void) {
+    pthread_mutex_lock(&travaFiltro);
+    totaisFiltro.consultas += contadoresFiltro.consultas;
+    totaisFiltro.rejeitadas += contadoresFiltro.rejeitadas;
+    totaisFiltro.falsosPositivos += contadoresFiltro.falsosPositivos;
+    pthread_mutex_unlock(&travaFiltro);
+    contadoresFiltro = (ContadoresFiltro){ 0, 0, 0 };
+}
+
+// Com o hash perfeito: um hash da chave, uma posição e uma comparação
+static HashItem* buscarItemPerfeito(TabelaHash *tabela, IdTexto chave) {
+    uint64_t hp = hashRapido64(textoDoId(chave), tamanhoDoId(chave), tabela->semente);
+    HashItem *item = &tabela->itens[posicaoPerfeita(hp, tabela->pilotos[baldePerfeito(hp, tabela->numBaldes)],
+                                                   tabela->quantidade)];
+    return item->hash == (uint32_t)(hp >> 32) && item->pista == chave ? item : NULL;
+}
+
+/**
+ * Sonda a tabela atrás de uma chave normalizada de hash 'h', sem passar pelo
+ * filtro de Bloom nem mexer nos contadores dele (manutenção interna da tabela).
+ * Graças ao Robin Hood, a busca para assim que encontra uma posição livre
+ * ou um item mais próximo da própria posição ideal do que a sondagem atual.
+ * Cada passo da sondagem compara o hash guardado no item e, só se ele bater, o id da chave.
+ * Com o hash perfeito, é um hash da chave, uma posição e uma comparação de id.
+ * Retorna o ponteiro para o item, ou NULL se a chave não estiver na tabela.
+ */
+static HashItem* sondarItem(TabelaHash *tabela, IdTexto chave, unsigned int h) {
+    if (tabela->pilotos != NULL) {
+        return buscarItemPerfeito(tabela, chave);
+    }
+    unsigned int mascara = tabela->capacidade - 1;
+    unsigned int indice = h & mascara;
+    unsigned int distancia = 1;
+    while (tabela->itens[indice].distancia >= distancia) {
+        if (tabela->itens[indice].hash == h && tabela->itens[indice].pista == chave) {
+            return &tabela->itens[indice];
+        }
+        indice = (indice + 1) & mascara;
+        distancia++;
+    }
+    return NULL;
+}
+
+/**
+ * Procura a posição de uma pista (qualquer grafia dela) na tabela, como sondarItem.
+ * Se houver filtro de Bloom, ele é consultado primeiro: pistas sem associação
+ * costumam parar ali, sem nenhuma sondagem. As consultas contam para --stats.
+ * Retorna o ponteiro para o item, ou NULL se a pista não estiver na tabela.
+ */
+static HashItem* buscarItem(TabelaHash *tabela, IdTexto pista) {
+    IdTexto chave = chaveDoId(pista);
+    unsigned int h = hashDoTexto(chave);
+    if (tabela->filtro != NULL) {
+        contadoresFiltro.consultas++;
+        if (!bitsDoFiltro(tabela, h, 0)) {
+            contadoresFiltro.rejeitadas++;
+            return NULL;
+        }
+    }
+    HashItem *item = sondarItem(tabela, chave, h);
+    if (item == NULL && tabela->filtro != NULL) {
+        contadoresFiltro.falsosPositivos++;
+    }
+    return item;
+}
+
+/**
+ * Devolve o número denso de um suspeito, cadastrando-o se for a primeira vez.
+ * Grafias com a mesma chave normalizada são o mesmo suspeito; vale o primeiro nome visto.
+ * Tabela, O ponteiro para a TabelaHash.
+ * O id do nome do suspeito.
+ */
+static unsigned int registrarSuspeito(TabelaHash *tabela, IdTexto nomeSuspeito) {
+    IdTexto idSuspeito = chaveDoId(nomeSuspeito);
+    if (idSuspeito >= tabela->tamanhoSuspeitoDoTexto) {
+        unsigned int novoTamanho = tabela->tamanhoSuspeitoDoTexto ? tabela->tamanhoSuspeitoDoTexto : 64;
+        while (novoTamanho <= idSuspeito) {
+            novoTamanho *= 2;
+        }
+        tabela->suspeitoDoTexto = (unsigned int*)realloc(tabela->suspeitoDoTexto, novoTamanho * sizeof(unsigned int));
+        if (tabela->suspeitoDoTexto == NULL) {
+            perror("Erro de alocação de memória para o cadastro de suspeitos");
+            exit(EXIT_FAILURE);
+        }
+        for (unsigned int i = tabela->tamanhoSuspeitoDoTexto; i < novoTamanho; i++) {
+            tabela->suspeitoDoTexto[i] = SEM_SUSPEITO;
+        }
+        tabela->tamanhoSuspeitoDoTexto = novoTamanho;
+    }
+    if (tabela->suspeitoDoTexto[idSuspeito] != SEM_SUSPEITO) {
+        return tabela->suspeitoDoTexto[idSuspeito];
+    }
+
+    if (tabela->numSuspeitos == tabela->capacidadeSuspeitos) {
+        tabela->capacidadeSuspeitos = tabela->capacidadeSuspeitos ? tabela->capacidadeSuspeitos * 2 : 16;
+        tabela->suspeitos = (IdTexto*)realloc(tabela->suspeitos, tabela->capacidadeSuspeitos * sizeof(IdTexto));
+        tabela->pistasDoSuspeito = (ListaPistas*)realloc(tabela->pistasDoSuspeito, tabela->capacidadeSuspeitos * sizeof(ListaPistas));
+        if (tabela->suspeitos == NULL || tabela->pistasDoSuspeito == NULL) {
+            perror("Erro de alocação de memória para o cadastro de suspeitos");
+            exit(EXIT_FAILURE);
+        }
+    }
+    tabela->suspeitos[tabela->numSuspeitos] = nomeSuspeito;
+    tabela->pistasDoSuspeito[tabela->numSuspeitos] = (ListaPistas){ NULL, 0, 0 };
+    tabela->suspeitoDoTexto[idSuspeito] = tabela->numSuspeitos;
+    return tabela->numSuspeitos++;
+}
+
+/**
+ * Número denso do suspeito com esse nome (em qualquer grafia), sem cadastrar nada.
+ * Retorna SEM_SUSPEITO se o texto não for nome de nenhum suspeito.
+ */
+static unsigned int procurarSuspeito(const TabelaHash *tabela, IdTexto idTexto) {
+    if (idTexto == TEXTO_INEXISTENTE) {
+        return SEM_SUSPEITO;
+    }
+    IdTexto chave = chaveDoId(idTexto);
+    if (chave >= tabela->tamanhoSuspeitoDoTexto) {
+        return SEM_SUSPEITO;
+    }
+    return tabela->suspeitoDoTexto[chave];
+}
+
+// Acrescenta uma pista à lista reversa de um suspeito e devolve a posição dela
+static unsigned int anexarPistaAoSuspeito(TabelaHash *tabela, unsigned int suspeito, IdTexto pista) {
+    ListaPistas *lista = &tabela->pistasDoSuspeito[suspeito];
+    if (lista->quantidade == lista->capacidade) {
+        lista->capacidade = lista->capacidade ? lista->capacidade * 2 : 4;
+        lista->pistas = (IdTexto*)realloc(lista->pistas, lista->capacidade * sizeof(IdTexto));
+        if (lista->pistas == NULL) {
+            perror("Erro de alocação de memória para o índice reverso");
+            exit(EXIT_FAILURE);
+        }
+    }
+    lista->pistas[lista->quantidade] = pista;
+    return lista->quantidade++;
+}
+
+/**
+ * Tira a pista do item da lista reversa do seu suspeito atual em O(1):
+ * a última pista da lista ocupa o lugar dela (e seu item é corrigido).
+ */
+static void removerPistaDoSuspeito(TabelaHash *tabela, HashItem *item);
+
+/**
+ * Associa pista -> suspeito na Tabela Hash a partir de ids já internados.
+ * A chave é a forma normalizada da pista, então grafias diferentes se encontram.
+ * Resolve colisões com endereçamento aberto (Robin Hood) e cresce
+ * automaticamente quando o fator de carga passa do limite.
+ * Se a pista já existir, apenas troca o suspeito (e guarda a grafia mais recente).
+ * Retorna o índice onde a nova associação ficou, ou capacidade se foi atualização.
+ */
+static unsigned int associarNaHash(TabelaHash *tabela, IdTexto idPista, IdTexto idSuspeito) {
+    IdTexto chave = chaveDoId(idPista);
+    HashItem *existente = sondarItem(tabela, chave, hashDoTexto(chave)); // Sem filtro: não é consulta de jogador
+    if (existente != NULL) {
+        // Se a chave já existe, apenas atualiza o valor (e o índice reverso)
+        unsigned int suspeito = registrarSuspeito(tabela, idSuspeito);
+        if (suspeito != existente->indiceSuspeito) {
+            removerPistaDoSuspeito(tabela, existente);
+            existente->indiceSuspeito = suspeito;
+            existente->posicaoNaLista = anexarPistaAoSuspeito(tabela, suspeito, idPista);
+        } else {
+            tabela->pistasDoSuspeito[suspeito].pistas[existente->posicaoNaLista] = idPista;
+        }
+        return tabela->capacidade;
+    }
+
+    if (tabela->pilotos != NULL) {
+        desfazerPerfeita(tabela);
+    }
+    if ((unsigned long long)(tabela->quantidade + 1) * CARGA_MAXIMA_DEN > (unsigned long long)tabela->capacidade * CARGA_MAXIMA_NUM) {
+        redimensionarHash(tabela);
+    }
+
+    HashItem novoItem;
+    novoItem.pista = chave;
+    novoItem.hash = hashDoTexto(novoItem.pista);
+    novoItem.indiceSuspeito = registrarSuspeito(tabela, idSuspeito);
+    novoItem.posicaoNaLista = anexarPistaAoSuspeito(tabela, novoItem.indiceSuspeito, idPista);
+
+    unsigned int indice = posicionarItem(tabela->itens, tabela->capacidade, novoItem);
+    tabela->quantidade++;
+    if (tabela->filtro != NULL) {
+        bitsDoFiltro(tabela, novoItem.hash, 1);
+    }
+    return indice;
+}
+
+/**
+ * Insere a associação pista/suspeito na Tabela Hash.
+ *  Tabela, O ponteiro para a TabelaHash.
+ *  A pista (chave) a ser associada.
+ *  O suspeito (valor) correspondente à pista.
+ */
+static void inserirNaHash(TabelaHash *tabela, const char *pista, const char *suspeito) {
+    uint64_t inicio = INICIAR_MEDIDA();
+    unsigned int indice = associarNaHash(tabela, internarTexto(pista), internarTexto(suspeito));
+    if (indice != tabela->capacidade) {
+        DEPURACAO("> Associação na Hash: Pista '%s' -> Suspeito '%s' inserida no índice %u.\n", pista, suspeito, indice);
+    }
+    TERMINAR_MEDIDA(FASE_INSERIR_HASH, inicio);
+}
+
+/**
+ * Consulta o suspeito correspondente a uma pista na Tabela Hash.
+ * Tabela, O ponteiro para a TabelaHash.
+ * A pista (chave) a ser procurada.
+ * O ponteiro para a string do nome do suspeito, ou NULL se não for encontrada.
+ */
+static const char* encontrarSuspeito(TabelaHash *tabela, const char *pista) {
+    size_t tamanho = strlen(pista);
+    char chave[TAMANHO_LINHA_COMANDO];
+    if (tabela->pilotos != NULL && tamanho <= sizeof(chave)) {
+        // Hash perfeito: a chave normalizada vai direto para a sua posição, sem passar pelos internados
+        size_t tamanhoChave = normalizarChave(pista, tamanho, chave);
+        uint64_t hp = hashRapido64(chave, tamanhoChave, tabela->semente);
+        HashItem *item = &tabela->itens[posicaoPerfeita(hp, tabela->pilotos[baldePerfeito(hp, tabela->numBaldes)],
+                                                       tabela->quantidade)];
+        if (item->hash != (uint32_t)(hp >> 32) || tamanhoDoId(item->pista) != tamanhoChave ||
+            memcmp(textoDoId(item->pista), chave, tamanhoChave) != 0) {
+            return NULL;
+        }
+        return textoDoId(tabela->suspeitos[item->indiceSuspeito]);
+    }
+    IdTexto idPista = buscarChave(pista);
+    if (idPista == TEXTO_INEXISTENTE) {
+        return NULL; // Nenhuma grafia desse texto foi vista: não pode estar na hash
+    }
+    HashItem *item = buscarItem(tabela, idPista);
+    return item != NULL ? textoDoId(tabela->suspeitos[item->indiceSuspeito]) : NULL; // NULL: pista não encontrada na hash
+}
+
+/**
+ * Mesma consulta de encontrarSuspeito, mas por id (sem tocar em strings) e sem o
+ * filtro de Bloom: é a consulta de referência das conferências (contarPistas),
+ * que não devem aparecer nos contadores do filtro.
+ * Retorna o id do suspeito, ou TEXTO_INEXISTENTE se a pista não tiver associação.
+ */
+static IdTexto encontrarSuspeitoId(TabelaHash *tabela, IdTexto pista) {
+    IdTexto chave = chaveDoId(pista);
+    HashItem *item = sondarItem(tabela, chave, hashDoTexto(chave));
+    return item != NULL ? tabela->suspeitos[item->indiceSuspeito] : TEXTO_INEXISTENTE;
+}
+
+static void removerPistaDoSuspeito(TabelaHash *tabela, HashItem *item) {
+    ListaPistas *lista = &tabela->pistasDoSuspeito[item->indiceSuspeito];
+    IdTexto ultima = lista->pistas[--lista->quantidade];
+    IdTexto chave = chaveDoId(ultima);
+    if (chave != item->pista) {
+        lista->pistas[item->posicaoNaLista] = ultima;
+        sondarItem(tabela, chave, hashDoTexto(chave))->posicaoNaLista = item->posicaoNaLista;
+    }
+}
+
+// Texto original da pista de um item (a chave guardada no item é a forma normalizada)
+static IdTexto textoOriginalDoItem(const TabelaHash *tabela, const HashItem *item) {
+    return tabela->pistasDoSuspeito[item->indiceSuspeito].pistas[item->posicaoNaLista];
+}
+
+/**
+ * Consulta todas as pistas do caso associadas a um suspeito.
+ * Custa O(1) para achar a lista; percorrê-la custa o tamanho da resposta.
+ * Pistas, recebe o vetor de ids dos textos originais (válido até a próxima associação).
+ * Retorna quantas pistas o suspeito tem (0 se o nome não for de um suspeito).
+ */
+static unsigned int pistasDoSuspeito(const TabelaHash *tabela, IdTexto idSuspeito, const IdTexto **pistas) {
+    unsigned int suspeito = procurarSuspeito(tabela, idSuspeito);
+    if (suspeito == SEM_SUSPEITO) {
+        *pistas = NULL;
+        return 0;
+    }
+    *pistas = tabela->pistasDoSuspeito[suspeito].pistas;
+    return tabela->pistasDoSuspeito[suspeito].quantidade;
+}
+
+/**
+ * Gera um hash perfeito mínimo para as associações (hash-and-displace, como o CHD):
+ * as chaves são divididas em baldes de ~CHAVES_POR_BALDE; do maior balde para o
+ * menor, procura-se o primeiro piloto que leva todas as chaves do balde a
+ * posições ainda livres de 0..n-1. No fim, cada item vai para a sua posição e
+ * a busca passa a ser um hash, uma posição e uma comparação.
+ * Se algum balde esgotar LIMITE_PILOTO, tenta outra semente.
+ * Retorna 0 se a tabela passou a usar o hash perfeito ou -1 caso contrário.
+ */
+static int gerarPerfeita(TabelaHash *tabela) {
+    uint32_t n = tabela->quantidade;
+    if (n == 0) {
+        return -1;
+    }
+    if (tabela->pilotos != NULL) {
+        desfazerPerfeita(tabela);
+    }
+    uint32_t numBaldes = (n + CHAVES_POR_BALDE - 1) / CHAVES_POR_BALDE;
+    HashItem *itens = (HashItem*)malloc((size_t)n * sizeof(HashItem));
+    uint64_t *hashes = (uint64_t*)malloc((size_t)n * sizeof(uint64_t));
+    uint32_t *membros = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));  // Chaves agrupadas por balde
+    uint32_t *posicoes = (uint32_t*)malloc((size_t)n * sizeof(uint32_t)); // Chave -> posição final
+    unsigned char *ocupada = (unsigned char*)malloc(n);
+    uint32_t *inicio = (uint32_t*)malloc(((size_t)numBaldes + 1) * sizeof(uint32_t)); // Balde -> primeiro membro
+    uint32_t *ordem = (uint32_t*)malloc((size_t)numBaldes * sizeof(uint32_t));         // Baldes do maior ao menor
+    uint32_t *pilotos = (uint32_t*)malloc((size_t)numBaldes * sizeof(uint32_t));
+    if (itens == NULL || hashes == NULL || membros == NULL || posicoes == NULL || ocupada == NULL ||
+        inicio == NULL || ordem == NULL || pilotos == NULL) {
+        perror("Erro de alocação de memória para o hash perfeito");
+        exit(EXIT_FAILURE);
+    }
+    uint32_t k = 0;
+    for (unsigned int i = 0; i < tabela->capacidade; i++) {
+        if (tabela->itens[i].distancia != 0) {
+            itens[k++] = tabela->itens[i];
+        }
+    }
+
+    uint64_t semente = 0;
+    int pronto = 0;
+    for (int tentativa = 0; tentativa < TENTATIVAS_SEMENTE && !pronto; tentativa++) {
+        semente = finalizar64((uint64_t)tentativa + 1);
+
+        // Baldes em CSR: conta, acumula e distribui (ordem serve de cursor por enquanto)
+        memset(inicio, 0, ((size_t)numBaldes + 1) * sizeof(uint32_t));
+        for (uint32_t i = 0; i < n; i++) {
+            hashes[i] = hashRapido64(textoDoId(itens[i].pista), tamanhoDoId(itens[i].pista), semente);
+            inicio[baldePerfeito(hashes[i], numBaldes) + 1]++;
+        }
+        uint32_t maiorBalde = 0;
+        for (uint32_t b = 0; b < numBaldes; b++) {
+            if (inicio[b + 1] > maiorBalde) maiorBalde = inicio[b + 1];
+            inicio[b + 1] += inicio[b];
+            ordem[b] = inicio[b];
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            membros[ordem[baldePerfeito(hashes[i], numBaldes)]++] = i;
+        }
+
+        // Ordena os baldes por tamanho decrescente (contagem: tamanhos são pequenos)
+        uint32_t *porTamanho = (uint32_t*)calloc((size_t)maiorBalde + 2, sizeof(uint32_t));
+        if (porTamanho == NULL) {
+            perror("Erro de alocação de memória para o hash perfeito");
+            exit(EXIT_FAILURE);
+        }
+        for (uint32_t b = 0; b < numBaldes; b++) {
+            porTamanho[maiorBalde - (inicio[b + 1] - inicio[b]) + 1]++;
+        }
+        for (uint32_t t = 0; t <= maiorBalde; t++) {
+            porTamanho[t + 1] += porTamanho[t];
+        }
+        for (uint32_t b = 0; b < numBaldes; b++) {
+            ordem[porTamanho[maiorBalde - (inicio[b + 1] - inicio[b])]++] = b;
+        }
+        free(porTamanho);
+
+        memset(ocupada, 0, n);
+        pronto = 1;
+        for (uint32_t j = 0; j < numBaldes && pronto; j++) {
+            uint32_t b = ordem[j];
+            uint32_t primeiro = inicio[b], ultimo = inicio[b + 1];
+            uint32_t piloto;
+            for (piloto = 0; piloto < LIMITE_PILOTO; piloto++) {
+                uint32_t m = primeiro;
+                for (; m < ultimo; m++) {
+                    uint32_t posicao = posicaoPerfeita(hashes[membros[m]], piloto, n);
+                    if (ocupada[posicao]) {
+                        break;
+                    }
+                    ocupada[posicao] = 1;
+                    posicoes[membros[m]] = posicao;
+                }
+                if (m == ultimo) {
+                    break;
+                }
+                while (m > primeiro) {
+                    ocupada[posicoes[membros[--m]]] = 0; // Desfaz o piloto que colidiu
+                }
+            }
+            pilotos[b] = piloto;
+            pronto = piloto < LIMITE_PILOTO;
+        }
+    }
+
+    if (pronto) {
+        HashItem *novosItens = (HashItem*)malloc((size_t)n * sizeof(HashItem));
+        if (novosItens == NULL) {
+            perror("Erro de alocação de memória para o hash perfeito");
+            exit(EXIT_FAILURE);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            novosItens[posicoes[i]] = itens[i];
+            novosItens[posicoes[i]].hash = (uint32_t)(hashes[i] >> 32);
+            novosItens[posicoes[i]].distancia = 1;
+        }
+        free(tabela->itens);
+        tabela->itens = novosItens;
+        tabela->capacidade = n;
+        tabela->pilotos = pilotos;
+        tabela->numBaldes = numBaldes;
+        tabela->semente = semente;
+    } else {
+        free(pilotos);
+    }
+    free(itens);
+    free(hashes);
+    free(membros);
+    free(posicoes);
+    free(ocupada);
+    free(inicio);
+    free(ordem);
+    return pronto ? 0 : -1;
+}
+
+// Contabiliza no relatório uma chave encontrada após 'sondagens' posições visitadas
+static void registrarSondagem(RelatorioHash *relatorio, unsigned int sondagens) {
+    relatorio->ocupadas++;
+    relatorio->somaSondagens += sondagens;
+    if (sondagens > relatorio->sondagemMaxima) {
+        relatorio->sondagemMaxima = sondagens;
+    }
+    relatorio->histograma[(sondagens < FAIXAS_SONDAGEM ? sondagens : FAIXAS_SONDAGEM) - 1]++;
+}
+
+// Maior sequência circular de posições ocupadas; ocupada(i) diz se a posição i tem chave
+static unsigned int medirAglomerado(unsigned int capacidade, const void *vetor,
+                                    int (*ocupada)(const void *vetor, unsigned int i)) {
+    unsigned int maior = 0, atual = 0;
+    // Duas voltas para contar a sequência que cruza o fim do vetor
+    for (unsigned int i = 0; i < 2 * capacidade && maior < capacidade; i++) {
+        if (ocupada(vetor, i & (capacidade - 1))) {
+            atual++;
+            if (atual > maior) {
+                maior = atual;
+            }
+        } else {
+            atual = 0;
+        }
+    }
+    return maior;
+}
+
+static int itemOcupado(const void *vetor, unsigned int i) {
+    return ((const HashItem*)vetor)[i].distancia != 0;
+}
+
+static int internoOcupado(const void *vetor, unsigned int i) {
+    return ((const IdTexto*)vetor)[i] != 0;
+}
+
+/**
+ * Mede a distribuição da tabela de associações: ocupação, sondagem máxima e média
+ * (cada chave é achada depois de 'distancia' posições visitadas) e o maior aglomerado.
+ */
+static void relatorioHash(const TabelaHash *tabela, RelatorioHash *relatorio) {
+    memset(relatorio, 0, sizeof(*relatorio));
+    relatorio->capacidade = tabela->capacidade;
+    for (unsigned int i = 0; i < tabela->capacidade; i++) {
+        if (tabela->itens[i].distancia != 0) {
+            registrarSondagem(relatorio, tabela->itens[i].distancia);
+        }
+    }
+    relatorio->maiorAglomerado = medirAglomerado(tabela->capacidade, tabela->itens, itemOcupado);
+}
+
+// Mesmo relatório para o conjunto de strings internadas (sondagem linear simples)
+static void relatorioInternos(RelatorioHash *relatorio) {
+    memset(relatorio, 0, sizeof(*relatorio));
+    relatorio->capacidade = internos.capacidadePosicoes;
+    unsigned int mascara = internos.capacidadePosicoes - 1;
+    for (unsigned int i = 0; i < internos.capacidadePosicoes; i++) {
+        if (internos.posicoes[i] != 0) {
+            unsigned int ideal = internos.hashes[internos.posicoes[i] - 1] & mascara;
+            registrarSondagem(relatorio, ((i - ideal) & mascara) + 1);
+        }
+    }
+    if (internos.capacidadePosicoes != 0) {
+        relatorio->maiorAglomerado = medirAglomerado(internos.capacidadePosicoes, internos.posicoes, internoOcupado);
+    }
+}
+
+// Imprime um relatório de distribuição; cada linha começa com 'prefixo' (ex.: "# " no TSV)
+static void imprimirRelatorioHash(FILE *saida, const char *prefixo, const char *titulo, const RelatorioHash *relatorio) {
+    fprintf(saida, "%s%s: %u/%u posições ocupadas (%.1f%%), sondagem máxima %u, média %.3f, maior aglomerado %u\n",
+            prefixo, titulo, relatorio->ocupadas, relatorio->capacidade,
+            relatorio->capacidade ? 100.0 * relatorio->ocupadas / relatorio->capacidade : 0.0,
+            relatorio->sondagemMaxima,
+            relatorio->ocupadas ? (double)relatorio->somaSondagens / relatorio->ocupadas : 0.0,
+            relatorio->maiorAglomerado);
+    fprintf(saida, "%s  sondagens:", prefixo);
+    for (unsigned int i = 0; i < FAIXAS_SONDAGEM; i++) {
+        fprintf(saida, " %u%s=%u", i + 1, i + 1 == FAIXAS_SONDAGEM ? "+" : "", relatorio->histograma[i]);
+    }
+    fprintf(saida, "\n");
+}
+
+// --- 3. CARREGAMENTO E GRAVAÇÃO DE CASOS ---
+
+/*
+ * Formato texto (.txt), lido linha a linha:
+ *
+ *   # comentário (linhas vazias também são ignoradas)
+ *   S<TAB>pai<TAB>lado<TAB>nome da sala<TAB>pista
+ *   A<TAB>pista<TAB>suspeito
+ *
+ * - As salas são numeradas 0, 1, 2... na ordem em que aparecem no arquivo.
+ * - 'pai' é o número de uma sala declarada antes, ou '-' para o Hall (raiz).
+ * - 'lado' é 'e' (esquerda) ou 'd' (direita); na raiz é ignorado ('-').
+ * - A pista pode ficar vazia (sala sem pista); o último campo pode ser omitido.
+ * - Linhas 'A' podem aparecer em qualquer ponto e repetir uma pista (o suspeito é trocado).
+ * - Nenhum campo passa de 65535 bytes (TAMANHO_MAXIMO_TEXTO), o limite do formato binário.
+ *
+ * Formato binário (.dqc), todos os inteiros em little-endian:
+ *
+ *   "DQC1"  u32 numSalas  u32 numAssociacoes
+ *   numSalas x        { u32 pai (0xFFFFFFFF = raiz)  u8 lado ('e'/'d')
+ *                       u16 tamNome  nome  u16 tamPista  pista }
+ *   numAssociacoes x  { u16 tamPista  pista  u16 tamSuspeito  suspeito }
+ *
+ * Os dois formatos são lidos via mmap numa única passada: os textos são
+ * internados direto dos bytes mapeados, sem cópias intermediárias.
+ */
+
+// Lê inteiros little-endian de um buffer sem exigir alinhamento
+static uint32_t lerU32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t lerU16(const unsigned char *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void gravarU32(FILE *arquivo, uint32_t valor) {
+    unsigned char bytes[4] = { valor & 0xFF, (valor >> 8) & 0xFF, (valor >> 16) & 0xFF, (valor >> 24) & 0xFF };
+    fwrite(bytes, 1, 4, arquivo);
+}
+
+/**
+ * Grava um texto precedido do tamanho em u16.
+ * Retorna 0 ou -1 (sem gravar nada) se o texto passar de TAMANHO_MAXIMO_TEXTO bytes.
+ */
+static int gravarTextoCurto(FILE *arquivo, IdTexto id) {
+    const char *texto = textoDoId(id);
+    size_t tamanho = strlen(texto);
+    if (tamanho > TAMANHO_MAXIMO_TEXTO) {
+        return -1;
+    }
+    unsigned char bytes[2] = { tamanho & 0xFF, (tamanho >> 8) & 0xFF };
+    fwrite(bytes, 1, 2, arquivo);
+    fwrite(texto, 1, tamanho, arquivo);
+    return 0;
+}
+
+/**
+ * Pendura uma sala lida do arquivo na mansão do caso.
+ * Pai, o número da sala pai (SALA_SEM_PAI para a raiz).
+ * Lado, 'e' ou 'd' (ignorado na raiz).
+ * Retorna 0 em caso de sucesso ou -1 se a ligação for inválida.
+ */
+static int adicionarSalaLida(Caso *caso, MontadorMansao *montador, uint32_t pai, char lado, IdTexto nome, IdTexto pista) {
+    NoSala **destino;
+    if (pai == SALA_SEM_PAI) {
+        if (caso->mansao != NULL) {
+            fprintf(stderr, "Erro: a mansão tem mais de uma raiz.\n");
+            return -1;
+        }
+        destino = &caso->mansao;
+    } else {
+        if (pai >= montador->quantidade) {
+            fprintf(stderr, "Erro: sala pai %u ainda não foi declarada.\n", pai);
+            return -1;
+        }
+        if (lado == 'e') {
+            destino = &montador->salas[pai]->esquerda;
+        } else if (lado == 'd') {
+            destino = &montador->salas[pai]->direita;
+        } else {
+            fprintf(stderr, "Erro: lado '%c' inválido (use 'e' ou 'd').\n", lado);
+            return -1;
+        }
+        if (*destino != NULL) {
+            fprintf(stderr, "Erro: a sala %u já tem um filho à %s.\n", pai, lado == 'e' ? "esquerda" : "direita");
+            return -1;
+        }
+    }
+
+    if (montador->quantidade == montador->capacidade) {
+        montador->capacidade = montador->capacidade ? montador->capacidade * 2 : 1024;
+        montador->salas = (NoSala**)realloc(montador->salas, montador->capacidade * sizeof(NoSala*));
+        if (montador->salas == NULL) {
+            perror("Erro de alocação de memória para MontadorMansao");
+            exit(EXIT_FAILURE);
+        }
+    }
+    *destino = novaSala(&caso->arenaMontagem, nome, pista);
+    montador->salas[montador->quantidade++] = *destino;
+    return 0;
+}
+
+// Lê um número decimal ou '-' (SALA_SEM_PAI) de um campo do arquivo texto
+static int lerIndicePai(const char *campo, size_t tamanho, uint32_t *pai) {
+    if (tamanho == 1 && campo[0] == '-') {
+        *pai = SALA_SEM_PAI;
+        return 0;
+    }
+    if (tamanho == 0 || tamanho > 9) {
+        return -1;
+    }
+    uint32_t valor = 0;
+    for (size_t i = 0; i < tamanho; i++) {
+        if (!isdigit((unsigned char)campo[i])) {
+            return -1;
+        }
+        valor = valor * 10 + (uint32_t)(campo[i] - '0');
+    }
+    *pai = valor;
+    return 0;
+}
+
+/**
+ * Monta mansão e associações a partir do conteúdo de um arquivo texto.
+ * Retorna 0 em caso de sucesso ou -1 (com a linha do erro em stderr).
+ */
+static int carregarCasoTexto(Caso *caso, const char *dados, size_t tamanho, const char *caminho) {
+    MontadorMansao montador = { NULL, 0, 0 };
+    const char *fim = dados + tamanho;
+    const char *linha = dados;
+    unsigned int numeroLinha = 0;
+    int resultado = 0;
+
+    while (linha < fim && resultado == 0) {
+        const char *fimLinha = (const char*)memchr(linha, '\n', (size_t)(fim - linha));
+        if (fimLinha == NULL) {
+            fimLinha = fim;
+        }
+        const char *fimConteudo = fimLinha;
+        if (fimConteudo > linha && fimConteudo[-1] == '\r') {
+            fimConteudo--;
+        }
+        numeroLinha++;
+
+        if (fimConteudo > linha && linha[0] != '#') {
+            // Separa até 5 campos por TAB
+            const char *campo[5];
+            size_t tamanhoCampo[5];
+            int numCampos = 0;
+            const char *inicio = linha;
+            while (numCampos < 5) {
+                const char *tab = numCampos < 4 ? (const char*)memchr(inicio, '\t', (size_t)(fimConteudo - inicio)) : NULL;
+                const char *fimCampo = tab != NULL ? tab : fimConteudo;
+                campo[numCampos] = inicio;
+                tamanhoCampo[numCampos] = (size_t)(fimCampo - inicio);
+                numCampos++;
+                if (tab == NULL) break;
+                inicio = tab + 1;
+            }
+
+            int textoLongo = 0;
+            for (int c = 1; c < numCampos; c++) {
+                if (tamanhoCampo[c] > TAMANHO_MAXIMO_TEXTO) textoLongo = 1;
+            }
+
+            if (textoLongo) {
+                fprintf(stderr, "%s:%u: texto com mais de %u bytes.\n", caminho, numeroLinha, TAMANHO_MAXIMO_TEXTO);
+                resultado = -1;
+            } else if (tamanhoCampo[0] == 1 && campo[0][0] == 'S' && numCampos >= 4) {
+                uint32_t pai;
+                if (lerIndicePai(campo[1], tamanhoCampo[1], &pai) != 0) {
+                    fprintf(stderr, "%s:%u: índice de sala pai inválido.\n", caminho, numeroLinha);
+                    resultado = -1;
+                } else {
+                    IdTexto nome = internarTextoN(campo[3], tamanhoCampo[3]);
+                    IdTexto pista = numCampos == 5 ? internarTextoN(campo[4], tamanhoCampo[4]) : TEXTO_VAZIO;
+                    char lado = tamanhoCampo[2] > 0 ? campo[2][0] : '?';
+                    if (adicionarSalaLida(caso, &montador, pai, lado, nome, pista) != 0) {
+                        fprintf(stderr, "%s:%u: sala rejeitada.\n", caminho, numeroLinha);
+                        resultado = -1;
+                    }
+                }
+            } else if (tamanhoCampo[0] == 1 && campo[0][0] == 'A' && numCampos == 3) {
+                associarNaHash(&caso->associacoes, internarTextoN(campo[1], tamanhoCampo[1]),
+                               internarTextoN(campo[2], tamanhoCampo[2]));
+            } else {
+                fprintf(stderr, "%s:%u: linha não reconhecida.\n", caminho, numeroLinha);
+                resultado = -1;
+            }
+        }
+        linha = fimLinha + 1;
+    }
+
+    free(montador.salas);
+    return resultado;
+}
+
+/**
+ * Monta mansão e associações a partir do conteúdo de um arquivo binário.
+ * Retorna 0 em caso de sucesso ou -1 se o arquivo estiver truncado ou inválido.
+ */
+static int carregarCasoBinario(Caso *caso, const unsigned char *dados, size_t tamanho, const char *caminho) {
+    MontadorMansao montador = { NULL, 0, 0 };
+    const unsigned char *p = dados + 4;
+    const unsigned char *fim = dados + tamanho;
+    int resultado = 0;
+
+    if (tamanho < 12) {
+        fprintf(stderr, "%s: cabeçalho truncado.\n", caminho);
+        return -1;
+    }
+    uint32_t numSalas = lerU32(p);
+    uint32_t numAssociacoes = lerU32(p + 4);
+    p += 8;
+    // Cada sala ocupa pelo menos 9 bytes e cada associação 4 (textos vazios):
+    // contagens que não cabem no resto do arquivo são rejeitadas antes de reservar
+    size_t restante = (size_t)(fim - p);
+    if (numSalas > restante / 9 || numAssociacoes > (restante - (size_t)numSalas * 9) / 4 ||
+            reservarHash(&caso->associacoes, (unsigned long long)caso->associacoes.quantidade + numAssociacoes) != 0) {
+        fprintf(stderr, "%s: contagens do cabeçalho maiores que o arquivo.\n", caminho);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < numSalas && resultado == 0; i++) {
+        if (fim - p < 7) { resultado = -1; break; }
+        uint32_t pai = lerU32(p);
+        char lado = (char)p[4];
+        uint16_t tamNome = lerU16(p + 5);
+        p += 7;
+        if (fim - p < tamNome + 2) { resultado = -1; break; }
+        IdTexto nome = internarTextoN((const char*)p, tamNome);
+        p += tamNome;
+        uint16_t tamPista = lerU16(p);
+        p += 2;
+        if (fim - p < tamPista) { resultado = -1; break; }
+        IdTexto pista = internarTextoN((const char*)p, tamPista);
+        p += tamPista;
+        if (adicionarSalaLida(caso, &montador, pai, lado, nome, pista) != 0) {
+            fprintf(stderr, "%s: sala %u rejeitada.\n", caminho, i);
+            resultado = -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < numAssociacoes && resultado == 0; i++) {
+        if (fim - p < 2) { resultado = -1; break; }
+        uint16_t tamPista = lerU16(p);
+        p += 2;
+        if (fim - p < tamPista + 2) { resultado = -1; break; }
+        IdTexto pista = internarTextoN((const char*)p, tamPista);
+        p += tamPista;
+        uint16_t tamSuspeito = lerU16(p);
+        p += 2;
+        if (fim - p < tamSuspeito) { resultado = -1; break; }
+        associarNaHash(&caso->associacoes, pista, internarTextoN((const char*)p, tamSuspeito));
+        p += tamSuspeito;
+    }
+
+    if (resultado != 0) {
+        fprintf(stderr, "%s: arquivo binário truncado ou inválido.\n", caminho);
+    }
+    free(montador.salas);
+    return resultado;
+}
+
+/**
+ * Mapeia um arquivo inteiro em memória para uma leitura sequencial.
+ * Tamanho, recebe o tamanho do arquivo.
+ * Retorna o início dos dados (a desfazer com munmap) ou NULL em caso de erro.
+ */
+static void* mapearArquivo(const char *caminho, size_t *tamanho) {
+    int descritor = open(caminho, O_RDONLY);
+    if (descritor < 0) {
+        perror(caminho);
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(descritor, &info) != 0 || info.st_size == 0) {
+        fprintf(stderr, "%s: arquivo vazio ou ilegível.\n", caminho);
+        close(descritor);
+        return NULL;
+    }
+    *tamanho = (size_t)info.st_size;
+    void *dados = mmap(NULL, *tamanho, PROT_READ, MAP_PRIVATE, descritor, 0);
+    close(descritor);
+    if (dados == MAP_FAILED) {
+        perror(caminho);
+        return NULL;
+    }
+    madvise(dados, *tamanho, MADV_SEQUENTIAL);
+    return dados;
+}
+
+/**
+ * Carrega um caso (texto ou binário, detectado pela assinatura) para um Caso
+ * já inicializado e vazio. O arquivo é mapeado em memória e lido uma vez.
+ * Retorna 0 em caso de sucesso ou -1 em caso de erro.
+ */
+int carregarCaso(Caso *caso, const char *caminho) {
+    uint64_t inicio = INICIAR_MEDIDA();
+    size_t tamanho;
+    void *dados = mapearArquivo(caminho, &tamanho);
+    if (dados == NULL) {
+        return -1;
+    }
+
+    int resultado;
+    if (tamanho >= 4 && memcmp(dados, MAGICO_CASO_BINARIO, 4) == 0) {
+        resultado = carregarCasoBinario(caso, (const unsigned char*)dados, tamanho, caminho);
+    } else {
+        resultado = carregarCasoTexto(caso, (const char*)dados, tamanho, caminho);
+    }
+    munmap(dados, tamanho);
+
+    if (resultado == 0 && caso->mansao == NULL) {
+        fprintf(stderr, "%s: o caso não declara nenhuma sala.\n", caminho);
+        resultado = -1;
+    }
+    TERMINAR_MEDIDA(FASE_CARREGAR_CASO, inicio);
+    return resultado;
+}
+
+/**
+ * Grava um caso já congelado no formato binário. A mansão compacta está em
+ * ordem de largura (BFS), o que garante que todo pai aparece antes dos filhos.
+ * Retorna 0 em caso de sucesso ou -1 em caso de erro.
+ */
+int salvarCasoBinario(Caso *caso, const char *caminho) {
+    const MansaoCompacta *mapa = &caso->mapa;
+    FILE *arquivo = fopen(caminho, "wb");
+    if (arquivo == NULL) {
+        perror(caminho);
+        return -1;
+    }
+
+    // O formato guarda o pai de cada sala; a mansão compacta guarda os filhos
+    uint32_t *pais = (uint32_t*)malloc((mapa->quantidade + 1) * sizeof(uint32_t));
+    if (pais == NULL) {
+        perror("Erro de alocação de memória para os pais das salas");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        pais[i] = SALA_SEM_PAI;
+    }
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        if (mapa->salas[i].esquerda != SEM_SALA) pais[mapa->salas[i].esquerda] = i;
+        if (mapa->salas[i].direita != SEM_SALA) pais[mapa->salas[i].direita] = i;
+    }
+
+    fwrite(MAGICO_CASO_BINARIO, 1, 4, arquivo);
+    gravarU32(arquivo, mapa->quantidade);
+    gravarU32(arquivo, caso->associacoes.quantidade);
+
+    int textoLongo = 0;
+    for (uint32_t i = 0; i < mapa->quantidade && !textoLongo; i++) {
+        const SalaCompacta *sala = &mapa->salas[i];
+        char lado = '-';
+        if (pais[i] != SALA_SEM_PAI) {
+            lado = mapa->salas[pais[i]].esquerda == i ? 'e' : 'd';
+        }
+        gravarU32(arquivo, pais[i]);
+        fputc(lado, arquivo);
+        textoLongo = gravarTextoCurto(arquivo, sala->nome) != 0 || gravarTextoCurto(arquivo, sala->pista) != 0;
+    }
+    free(pais);
+
+    for (unsigned int i = 0; i < caso->associacoes.capacidade && !textoLongo; i++) {
+        HashItem *item = &caso->associacoes.itens[i];
+        if (item->distancia != 0) {
+            textoLongo = gravarTextoCurto(arquivo, textoOriginalDoItem(&caso->associacoes, item)) != 0 ||
+                         gravarTextoCurto(arquivo, caso->associacoes.suspeitos[item->indiceSuspeito]) != 0;
+        }
+    }
+
+    int resultado = ferror(arquivo) || textoLongo ? -1 : 0;
+    if (fclose(arquivo) != 0) {
+        resultado = -1;
+    }
+    if (textoLongo) {
+        fprintf(stderr, "%s: texto com mais de %u bytes não cabe no formato binário.\n", caminho, TAMANHO_MAXIMO_TEXTO);
+    } else if (resultado != 0) {
+        fprintf(stderr, "%s: erro ao gravar o caso.\n", caminho);
+    }
+    if (resultado != 0) {
+        remove(caminho);
+    }
+    return resultado;
+}
+
+/*
+ * Formato do hash perfeito (.dqm), gerado por --gerar-mphf, inteiros em little-endian:
+ *
+ *   "DQM1"  u32 numChaves  u32 numBaldes  u32 sementeBaixa  u32 sementeAlta
+ *   numBaldes x  u32 piloto
+ *   numChaves x  { u16 tamPista  pista  u16 tamSuspeito  suspeito }   (na ordem das posições)
+ *
+ * As pistas são as chaves normalizadas. Como hashRapido64 lê a memória na ordem
+ * de bytes da máquina, o arquivo só vale onde foi gerado (ou em máquinas com a
+ * mesma ordem); carregarPerfeita confere a posição de cada chave antes de usá-lo.
+ */
+
+/**
+ * Grava o hash perfeito já gerado para as associações de um caso.
+ * Retorna 0 em caso de sucesso ou -1 em caso de erro.
+ */
+static int salvarPerfeita(const TabelaHash *tabela, const char *caminho) {
+    if (tabela->pilotos == NULL) {
+        fprintf(stderr, "%s: a tabela não tem hash perfeito para gravar.\n", caminho);
+        return -1;
+    }
+    FILE *arquivo = fopen(caminho, "wb");
+    if (arquivo == NULL) {
+        perror(caminho);
+        return -1;
+    }
+    fwrite(MAGICO_PERFEITA, 1, 4, arquivo);
+    gravarU32(arquivo, tabela->quantidade);
+    gravarU32(arquivo, tabela->numBaldes);
+    gravarU32(arquivo, (uint32_t)tabela->semente);
+    gravarU32(arquivo, (uint32_t)(tabela->semente >> 32));
+    for (uint32_t b = 0; b < tabela->numBaldes; b++) {
+        gravarU32(arquivo, tabela->pilotos[b]);
+    }
+    int textoLongo = 0;
+    for (uint32_t i = 0; i < tabela->quantidade && !textoLongo; i++) {
+        textoLongo = gravarTextoCurto(arquivo, tabela->itens[i].pista) != 0 ||
+                     gravarTextoCurto(arquivo, tabela->suspeitos[tabela->itens[i].indiceSuspeito]) != 0;
+    }
+
+    int resultado = ferror(arquivo) || textoLongo ? -1 : 0;
+    if (fclose(arquivo) != 0) {
+        resultado = -1;
+    }
+    if (textoLongo) {
+        fprintf(stderr, "%s: texto com mais de %u bytes não cabe no formato binário.\n", caminho, TAMANHO_MAXIMO_TEXTO);
+    } else if (resultado != 0) {
+        fprintf(stderr, "%s: erro ao gravar o hash perfeito.\n", caminho);
+    }
+    if (resultado != 0) {
+        remove(caminho);
+    }
+    return resultado;
+}
+
+/**
+ * Passa as associações de um caso já carregado para o hash perfeito do arquivo.
+ * Cada posição é conferida: a chave precisa existir no caso com o mesmo suspeito
+ * e o hash dela precisa levar exatamente àquela posição. Nada é internado.
+ * Retorna 0 em caso de sucesso ou -1 se o arquivo não corresponder ao caso.
+ */
+static int carregarPerfeita(TabelaHash *tabela, const char *caminho) {
+    size_t tamanho;
+    const unsigned char *dados = (const unsigned char*)mapearArquivo(caminho, &tamanho);
+    if (dados == NULL) {
+        return -1;
+    }
+    const unsigned char *fim = dados + tamanho;
+    if (tamanho < 20 || memcmp(dados, MAGICO_PERFEITA, 4) != 0) {
+        fprintf(stderr, "%s: não é um arquivo de hash perfeito.\n", caminho);
+        munmap((void*)dados, tamanho);
+        return -1;
+    }
+    uint32_t n = lerU32(dados + 4);
+    uint32_t numBaldes = lerU32(dados + 8);
+    uint64_t semente = lerU32(dados + 12) | ((uint64_t)lerU32(dados + 16) << 32);
+    const unsigned char *p = dados + 20;
+    if (n == 0 || n != tabela->quantidade || numBaldes == 0 || numBaldes > (size_t)(fim - p) / 4) {
+        fprintf(stderr, "%s: o hash perfeito não corresponde ao caso.\n", caminho);
+        munmap((void*)dados, tamanho);
+        return -1;
+    }
+
+    uint32_t *pilotos = (uint32_t*)malloc((size_t)numBaldes * sizeof(uint32_t));
+    HashItem *novosItens = (HashItem*)malloc((size_t)n * sizeof(HashItem));
+    if (pilotos == NULL || novosItens == NULL) {
+        perror("Erro de alocação de memória para o hash perfeito");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t b = 0; b < numBaldes; b++, p += 4) {
+        pilotos[b] = lerU32(p);
+    }
+
+    int resultado = 0;
+    for (uint32_t i = 0; i < n && resultado == 0; i++) {
+        if (fim - p < 2) { resultado = -1; break; }
+        uint16_t tamPista = lerU16(p);
+        p += 2;
+        if (fim - p < tamPista + 2) { resultado = -1; break; }
+        const char *pista = (const char*)p;
+        p += tamPista;
+        uint16_t tamSuspeito = lerU16(p);
+        p += 2;
+        if (fim - p < tamSuspeito) { resultado = -1; break; }
+        const char *suspeito = (const char*)p;
+        p += tamSuspeito;
+
+        uint64_t hp = hashRapido64(pista, tamPista, semente);
+        IdTexto idPista = buscarTextoN(pista, tamPista, hashN(pista, tamPista));
+        IdTexto idSuspeito = buscarTextoN(suspeito, tamSuspeito, hashN(suspeito, tamSuspeito));
+        HashItem *item = idPista != TEXTO_INEXISTENTE ? sondarItem(tabela, idPista, hashDoTexto(idPista)) : NULL;
+        if (item == NULL || item->pista != idPista || item->indiceSuspeito != procurarSuspeito(tabela, idSuspeito) ||
+            posicaoPerfeita(hp, pilotos[baldePerfeito(hp, numBaldes)], n) != i) {
+            resultado = -1;
+            break;
+        }
+        novosItens[i] = *item;
+        novosItens[i].hash = (uint32_t)(hp >> 32);
+        novosItens[i].distancia = 1;
+    }
+    munmap((void*)dados, tamanho);
+
+    if (resultado != 0) {
+        fprintf(stderr, "%s: o hash perfeito não corresponde ao caso.\n", caminho);
+        free(pilotos);
+        free(novosItens);
+        return -1;
+    }
+    free(tabela->itens);
+    tabela->itens = novosItens;
+    tabela->capacidade = n;
+    tabela->pilotos = pilotos;
+    tabela->numBaldes = numBaldes;
+    tabela->semente = semente;
+    return 0;
+}
+
+/**
+ * Congela uma mansão montada com NoSala num vetor compacto em ordem de largura.
+ * O próprio vetor de saída faz o papel da fila da BFS: a sala i é processada
+ * quando a fila chega em i, e seus filhos recebem os próximos índices livres.
+ * Raiz, o Hall de Entrada da mansão montada.
+ * Mapa, a mansão compacta a ser preenchida.
+ */
+static void congelarMansao(const NoSala *raiz, MansaoCompacta *mapa) {
+    uint32_t capacidade = 1024, quantidade = 0;
+    const NoSala **origem = (const NoSala**)malloc(capacidade * sizeof(NoSala*));
+    SalaCompacta *salas = (SalaCompacta*)malloc(capacidade * sizeof(SalaCompacta));
+    if (origem == NULL || salas == NULL) {
+        perror("Erro de alocação de memória para MansaoCompacta");
+        exit(EXIT_FAILURE);
+    }
+
+    if (raiz != NULL) {
+        origem[quantidade++] = raiz;
+    }
+    for (uint32_t i = 0; i < quantidade; i++) {
+        if (quantidade + 2 > capacidade) {
+            capacidade *= 2;
+            origem = (const NoSala**)realloc(origem, capacidade * sizeof(NoSala*));
+            salas = (SalaCompacta*)realloc(salas, capacidade * sizeof(SalaCompacta));
+            if (origem == NULL || salas == NULL) {
+                perror("Erro de alocação de memória para MansaoCompacta");
+                exit(EXIT_FAILURE);
+            }
+        }
+        const NoSala *no = origem[i];
+        salas[i].nome = no->nome;
+        salas[i].pista = no->pista;
+        salas[i].esquerda = SEM_SALA;
+        salas[i].direita = SEM_SALA;
+        if (no->esquerda != NULL) {
+            salas[i].esquerda = quantidade;
+            origem[quantidade++] = no->esquerda;
+        }
+        if (no->direita != NULL) {
+            salas[i].direita = quantidade;
+            origem[quantidade++] = no->direita;
+        }
+    }
+    free(origem);
+
+    // Devolve a folga do vetor: o mapa congelado nunca mais cresce
+    if (quantidade > 0) {
+        SalaCompacta *justo = (SalaCompacta*)realloc(salas, quantidade * sizeof(SalaCompacta));
+        if (justo != NULL) {
+            salas = justo;
+        }
+    }
+    mapa->salas = salas;
+    mapa->quantidade = quantidade;
+}
+
+// Aloca um vetor de 'quantidade' índices de sala (nunca devolve NULL)
+static uint32_t* alocarIndicesSala(size_t quantidade) {
+    uint32_t *vetor = (uint32_t*)malloc((quantidade + 1) * sizeof(uint32_t));
+    if (vetor == NULL) {
+        perror("Erro de alocação de memória para IndiceRotas");
+        exit(EXIT_FAILURE);
+    }
+    return vetor;
+}
+
+// Bit mais alto de x (x > 0)
+static unsigned int bitMaisAlto(uint32_t x) {
+    return 31u - (unsigned int)__builtin_clz(x);
+}
+
+/**
+ * Monta o índice de rotas da mansão congelada em O(salas): pais e profundidades
+ * numa passada pela ordem de largura, a pré-ordem com uma pilha explícita e,
+ * por fim, as máscaras de cada bloco e a tabela esparsa dos mínimos dos blocos.
+ */
+static void prepararRotas(MansaoCompacta *mapa) {
+    IndiceRotas *rotas = &mapa->rotas;
+    uint32_t n = mapa->quantidade;
+    memset(rotas, 0, sizeof(IndiceRotas));
+    if (n == 0) {
+        return;
+    }
+
+    rotas->pais = alocarIndicesSala(n);
+    rotas->profundidades = alocarIndicesSala(n);
+    rotas->pais[0] = SEM_SALA;
+    rotas->profundidades[0] = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const SalaCompacta *sala = &mapa->salas[i];
+        if (sala->esquerda != SEM_SALA) {
+            rotas->pais[sala->esquerda] = i;
+            rotas->profundidades[sala->esquerda] = rotas->profundidades[i] + 1;
+        }
+        if (sala->direita != SEM_SALA) {
+            rotas->pais[sala->direita] = i;
+            rotas->profundidades[sala->direita] = rotas->profundidades[i] + 1;
+        }
+    }
+
+    // Pré-ordem: a pilha guarda as salas ainda não visitadas (a direita fica por baixo)
+    rotas->entrada = alocarIndicesSala(n);
+    rotas->preordem = alocarIndicesSala(n);
+    uint32_t *pilha = alocarIndicesSala(n);
+    uint32_t topo = 0, posicao = 0;
+    pilha[topo++] = 0;
+    while (topo > 0) {
+        uint32_t sala = pilha[--topo];
+        rotas->entrada[sala] = posicao;
+        rotas->preordem[posicao++] = sala;
+        if (mapa->salas[sala].direita != SEM_SALA) pilha[topo++] = mapa->salas[sala].direita;
+        if (mapa->salas[sala].esquerda != SEM_SALA) pilha[topo++] = mapa->salas[sala].esquerda;
+    }
+    free(pilha);
+
+    // Máscaras: ao entrar uma posição, saem da pilha do bloco os maiores que ela
+    rotas->mascaras = alocarIndicesSala(n);
+    rotas->numBlocos = (n + BITS_BLOCO_ROTAS - 1) / BITS_BLOCO_ROTAS;
+    rotas->niveis = bitMaisAlto(rotas->numBlocos) + 1;
+    rotas->minimosBlocos = alocarIndicesSala((size_t)rotas->niveis * rotas->numBlocos);
+    for (uint32_t b = 0; b < rotas->numBlocos; b++) {
+        uint32_t inicio = b * BITS_BLOCO_ROTAS;
+        uint32_t fim = inicio + BITS_BLOCO_ROTAS < n ? inicio + BITS_BLOCO_ROTAS : n;
+        uint32_t pilhaBloco = 0;
+        for (uint32_t i = inicio; i < fim; i++) {
+            while (pilhaBloco != 0 && rotas->preordem[inicio + bitMaisAlto(pilhaBloco)] > rotas->preordem[i]) {
+                pilhaBloco &= ~(1u << bitMaisAlto(pilhaBloco));
+            }
+            pilhaBloco |= 1u << (i - inicio);
+            rotas->mascaras[i] = pilhaBloco;
+        }
+        // O fundo da pilha no fim do bloco é o mínimo do bloco inteiro
+        rotas->minimosBlocos[b] = rotas->preordem[inicio + (unsigned int)__builtin_ctz(pilhaBloco)];
+    }
+    for (uint32_t k = 1; k < rotas->niveis; k++) {
+        const uint32_t *anterior = rotas->minimosBlocos + (size_t)(k - 1) * rotas->numBlocos;
+        uint32_t *nivel = rotas->minimosBlocos + (size_t)k * rotas->numBlocos;
+        uint32_t metade = 1u << (k - 1);
+        for (uint32_t b = 0; b + 2 * metade <= rotas->numBlocos; b++) {
+            nivel[b] = anterior[b] < anterior[b + metade] ? anterior[b] : anterior[b + metade];
+        }
+    }
+}
+
+// Menor sala entre as posições 'de' e 'ate' (inclusive) de um mesmo bloco da pré-ordem
+static uint32_t minimoNoBloco(const IndiceRotas *rotas, uint32_t de, uint32_t ate) {
+    uint32_t candidatos = rotas->mascaras[ate] & (~0u << (de % BITS_BLOCO_ROTAS));
+    return rotas->preordem[ate - ate % BITS_BLOCO_ROTAS + (unsigned int)__builtin_ctz(candidatos)];
+}
+
+// Menor sala entre as posições 'de' e 'ate' (inclusive, de <= ate) da pré-ordem, em O(1)
+static uint32_t minimoNaPreordem(const IndiceRotas *rotas, uint32_t de, uint32_t ate) {
+    uint32_t blocoDe = de / BITS_BLOCO_ROTAS, blocoAte = ate / BITS_BLOCO_ROTAS;
+    if (blocoDe == blocoAte) {
+        return minimoNoBloco(rotas, de, ate);
+    }
+    uint32_t minimo = minimoNoBloco(rotas, de, blocoDe * BITS_BLOCO_ROTAS + BITS_BLOCO_ROTAS - 1);
+    uint32_t ultimo = minimoNoBloco(rotas, blocoAte * BITS_BLOCO_ROTAS, ate);
+    if (ultimo < minimo) minimo = ultimo;
+    if (blocoAte - blocoDe > 1) {
+        // Dois intervalos de 2^k blocos que se sobrepõem cobrem os blocos do meio
+        uint32_t primeiro = blocoDe + 1, quantos = blocoAte - blocoDe - 1;
+        unsigned int k = bitMaisAlto(quantos);
+        const uint32_t *nivel = rotas->minimosBlocos + (size_t)k * rotas->numBlocos;
+        uint32_t meio = nivel[primeiro] < nivel[blocoAte - (1u << k)] ? nivel[primeiro] : nivel[blocoAte - (1u << k)];
+        if (meio < minimo) minimo = meio;
+    }
+    return minimo;
+}
+
+// Ancestral comum mais profundo de duas salas, em O(1)
+static uint32_t ancestralComum(const MansaoCompacta *mapa, uint32_t a, uint32_t b) {
+    const IndiceRotas *rotas = &mapa->rotas;
+    if (a == b) {
+        return a;
+    }
+    uint32_t de = rotas->entrada[a], ate = rotas->entrada[b];
+    if (de > ate) {
+        uint32_t troca = de;
+        de = ate;
+        ate = troca;
+    }
+    // A sala mais rasa depois de 'de' até 'ate' é filha do ancestral comum
+    return rotas->pais[minimoNaPreordem(rotas, de + 1, ate)];
+}
+
+/**
+ * Caminho mais curto de 'origem' a 'destino': sobe ('v') até o ancestral comum
+ * e desce ('e'/'d') até o destino. Como snprintf, escreve no máximo
+ * capacidade - 1 movimentos e um '\0' em 'passos' (que pode ser NULL com
+ * capacidade 0). O ancestral sai em O(1); escrever os passos custa o tamanho da rota.
+ * Retorna o número de movimentos da rota inteira.
+ */
+static size_t rotaNaMansao(const MansaoCompacta *mapa, uint32_t origem, uint32_t destino, char *passos, size_t capacidade) {
+    const IndiceRotas *rotas = &mapa->rotas;
+    uint32_t comum = ancestralComum(mapa, origem, destino);
+    size_t subidas = rotas->profundidades[origem] - rotas->profundidades[comum];
+    size_t total = subidas + (rotas->profundidades[destino] - rotas->profundidades[comum]);
+    if (capacidade == 0) {
+        return total;
+    }
+
+    size_t escritos = total < capacidade - 1 ? total : capacidade - 1;
+    memset(passos, 'v', subidas < escritos ? subidas : escritos);
+    // A descida é escrita de trás para a frente, subindo do destino até o ancestral
+    for (uint32_t sala = destino; sala != comum; sala = rotas->pais[sala]) {
+        size_t i = subidas + (rotas->profundidades[sala] - rotas->profundidades[comum]) - 1;
+        if (i < escritos) {
+            passos[i] = mapa->salas[rotas->pais[sala]].esquerda == sala ? 'e' : 'd';
+        }
+    }
+    passos[escritos] = '\0';
+    return total;
+}
+
+/**
+ * Monta os índices por texto da mansão congelada em O(salas): o nome de cada
+ * sala e, no formato CSR (contagem, soma de prefixos e preenchimento), as
+ * salas de cada pista. Percorrer em ordem de largura deixa a primeira sala de
+ * cada nome e de cada pista como a mais próxima do Hall.
+ */
+static void indexarSalas(MansaoCompacta *mapa) {
+    IndiceSalas *indice = &mapa->indice;
+    memset(indice, 0, sizeof(IndiceSalas));
+    if (mapa->quantidade == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        IdTexto nome = chaveDoId(mapa->salas[i].nome);
+        IdTexto pista = chaveDoId(mapa->salas[i].pista);
+        if (nome >= indice->tamanho) indice->tamanho = nome + 1;
+        if (pista >= indice->tamanho) indice->tamanho = pista + 1;
+    }
+    indice->salaDoNome = alocarIndicesSala(indice->tamanho);
+    indice->inicioDaPista = alocarIndicesSala((size_t)indice->tamanho + 1);
+    memset(indice->inicioDaPista, 0, ((size_t)indice->tamanho + 1) * sizeof(uint32_t));
+    for (uint32_t c = 0; c < indice->tamanho; c++) {
+        indice->salaDoNome[c] = SEM_SALA;
+    }
+
+    // Contagem: inicioDaPista[c + 1] recebe quantas salas têm a pista c
+    uint32_t comPista = 0;
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        IdTexto nome = chaveDoId(mapa->salas[i].nome);
+        if (indice->salaDoNome[nome] == SEM_SALA) {
+            indice->salaDoNome[nome] = i;
+        }
+        if (mapa->salas[i].pista != TEXTO_VAZIO) {
+            indice->inicioDaPista[chaveDoId(mapa->salas[i].pista) + 1]++;
+            comPista++;
+        }
+    }
+    for (uint32_t c = 0; c < indice->tamanho; c++) {
+        indice->inicioDaPista[c + 1] += indice->inicioDaPista[c];
+    }
+
+    // Preenchimento: cada pista avança o seu cursor e depois os inícios são
+    // recuperados deslocando o vetor uma posição
+    indice->salasDaPista = alocarIndicesSala(comPista);
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        if (mapa->salas[i].pista != TEXTO_VAZIO) {
+            indice->salasDaPista[indice->inicioDaPista[chaveDoId(mapa->salas[i].pista)]++] = i;
+        }
+    }
+    memmove(indice->inicioDaPista + 1, indice->inicioDaPista, (size_t)indice->tamanho * sizeof(uint32_t));
+    indice->inicioDaPista[0] = 0;
+}
+
+/**
+ * Procura uma sala pelo nome (qualquer grafia); com nomes repetidos, fica a
+ * mais próxima do Hall. Custa a busca da chave nos internados: O(1).
+ * Retorna o índice da sala ou SEM_SALA.
+ */
+static uint32_t procurarSala(const MansaoCompacta *mapa, const char *nome) {
+    IdTexto chave = buscarChave(nome);
+    if (chave == TEXTO_INEXISTENTE || chave >= mapa->indice.tamanho) {
+        return SEM_SALA; // Nenhuma grafia desse nome foi vista, ou não é nome de sala
+    }
+    return mapa->indice.salaDoNome[chave];
+}
+
+/**
+ * Salas onde está a pista (qualquer grafia), da mais próxima do Hall para a
+ * mais distante. 'salas' aponta para dentro do índice. Custa O(1).
+ * Retorna quantas salas têm a pista (0 se nenhuma).
+ */
+static uint32_t procurarPista(const MansaoCompacta *mapa, const char *pista, const uint32_t **salas) {
+    IdTexto chave = buscarChave(pista);
+    *salas = NULL;
+    if (chave == TEXTO_INEXISTENTE || chave == TEXTO_VAZIO || chave >= mapa->indice.tamanho) {
+        return 0;
+    }
+    *salas = mapa->indice.salasDaPista + mapa->indice.inicioDaPista[chave];
+    return mapa->indice.inicioDaPista[chave + 1] - mapa->indice.inicioDaPista[chave];
+}
+
+// Libera os índices por texto
+static void liberarIndiceSalas(IndiceSalas *indice) {
+    free(indice->salaDoNome);
+    free(indice->inicioDaPista);
+    free(indice->salasDaPista);
+    memset(indice, 0, sizeof(IndiceSalas));
+}
+
+// Libera o índice de rotas
+static void liberarRotas(IndiceRotas *rotas) {
+    free(rotas->pais);
+    free(rotas->profundidades);
+    free(rotas->entrada);
+    free(rotas->preordem);
+    free(rotas->mascaras);
+    free(rotas->minimosBlocos);
+    memset(rotas, 0, sizeof(IndiceRotas));
+}
+
+/**
+ * Encerra a montagem do caso: congela a mansão, monta os índices de rotas e
+ * por texto e descarta os nós NoSala, que não são mais usados durante o jogo.
+ */
+void congelarCaso(Caso *caso) {
+    uint64_t inicio = INICIAR_MEDIDA();
+    congelarMansao(caso->mansao, &caso->mapa);
+    prepararRotas(&caso->mapa);
+    indexarSalas(&caso->mapa);
+    liberarArena(&caso->arenaMontagem);
+    caso->mansao = NULL;
+    TERMINAR_MEDIDA(FASE_CONGELAR, inicio);
+}
+
+/**
+ * Monta o caso clássico embutido no programa (usado quando nenhum
+ * arquivo de caso é informado).
+ */
+void montarCasoPadrao(Caso *caso) {
+    Arena *arena = &caso->arenaMontagem;
+
+    // --- Montagem do Mapa Fixo da Mansão (Árvore Binária) ---
+    SAIDA("\n--- Montando a Mansão ---\n");
+
+    // Nível 0 (Raiz)
+    NoSala *hall = criarSala(arena, "Hall de Entrada", "Estrela Azul");
+    caso->mansao = hall;
+
+    // Nível 1
+    hall->esquerda = criarSala(arena, "Cozinha", " Fogao sujo");
+    hall->direita = criarSala(arena, "Sala de Jantar", "Pratos sujos na mesa");
+
+    // Nível 2
+    hall->esquerda->esquerda = criarSala(arena, "Despensa", "Garrafa de azeite Vazia");
+    hall->esquerda->direita = criarSala(arena, "Biblioteca", "Livros fora de armario");
+    hall->direita->esquerda = criarSala(arena, "Sala de Estar", "Nenhum"); // Sem pista
+    hall->direita->direita = criarSala(arena, "Quarto Principal", "Um pequeno alfinete de lapela");
+
+    // Nível 3
+    hall->esquerda->direita->esquerda = criarSala(arena, "Escritório", "Nenhum"); // Sem pista
+    hall->direita->direita->esquerda = criarSala(arena, "Banheiro", "papel higienico");
+    hall->direita->direita->direita = criarSala(arena, "Closet", "cabelo no chão");
+
+    // --- Montagem das Associações Pista -> Suspeito (Tabela Hash) ---
+    SAIDA("\n--- Definindo as Associações de Pistas ---\n");
+    
+    // Suspeitos: Mordomo (Alfred), Jardineiro (Bartolomeu), Esposa (Cecília)
+    inserirNaHash(&caso->associacoes, "Anel de Prata", "Bartolomeu");
+    inserirNaHash(&caso->associacoes, "Fogão sujo", "Luzia");
+    inserirNaHash(&caso->associacoes, "pratos sujos na mesa", "Sebastiao");
+    inserirNaHash(&caso->associacoes, "Garrafa de Azeite Vazia", "Rafael");
+    inserirNaHash(&caso->associacoes, "Livros fora do armario", "Emilly");
+    inserirNaHash(&caso->associacoes, "Papel higienico", "Cecilia");
+    inserirNaHash(&caso->associacoes, "Tubo de batom vermelho", "Cecilia");
+    inserirNaHash(&caso->associacoes, "Cabelo no chão", "Cecilia");
+}
+
+// --- 4. ESTATÍSTICAS ---
+
+// Zera as estatísticas antes de acumular investigações
+static void iniciarEstatisticas(Estatisticas *estatisticas) {
+    memset(estatisticas, 0, sizeof(*estatisticas));
+}
+
+// Blocos e bytes reservados por uma arena
+static MemoriaEstrutura memoriaDaArena(const Arena *arena) {
+    MemoriaEstrutura memoria = { 0, 0 };
+    for (const BlocoArena *bloco = arena->atual; bloco != NULL; bloco = bloco->anterior) {
+        memoria.bytes += sizeof(BlocoArena) + bloco->capacidade;
+        memoria.alocacoes++;
+    }
+    return memoria;
+}
+
+/**
+ * Soma à estatística uma investigação terminada: nós, altura e profundidade
+ * média da árvore de pistas e as coletas repetidas. Também guarda o pico da
+ * arena, já que o modo roteiro a esvazia depois de cada sessão.
+ * A árvore é percorrida com pilha explícita (a AVL tem altura O(log n)).
+ */
+static void acumularInvestigacao(Estatisticas *estatisticas, const Investigacao *investigacao) {
+    const NoPista *pilha[2 * ALTURA_MAXIMA_AVL];
+    unsigned int profundidades[2 * ALTURA_MAXIMA_AVL];
+    int topo = 0;
+
+    estatisticas->investigacoes++;
+    estatisticas->pistasRepetidas += investigacao->pistasRepetidas;
+    MemoriaEstrutura arena = memoriaDaArena(investigacao->arena);
+    if (arena.bytes > estatisticas->memoriaArena.bytes) {
+        estatisticas->memoriaArena = arena;
+    }
+    if (investigacao->pistas != NULL) {
+        pilha[topo] = investigacao->pistas;
+        profundidades[topo++] = 0;
+    }
+    while (topo > 0) {
+        const NoPista *no = pilha[--topo];
+        unsigned int profundidade = profundidades[topo];
+        estatisticas->nosPistas++;
+        estatisticas->somaProfundidades += profundidade;
+        if (profundidade + 1 > estatisticas->alturaMaximaPistas) {
+            estatisticas->alturaMaximaPistas = profundidade + 1;
+        }
+        if (no->direita != NULL) {
+            pilha[topo] = no->direita;
+            profundidades[topo++] = profundidade + 1;
+        }
+        if (no->esquerda != NULL) {
+            pilha[topo] = no->esquerda;
+            profundidades[topo++] = profundidade + 1;
+        }
+    }
+}
+
+/**
+ * Salas, profundidade e folhas da mansão congelada. Como as salas estão em
+ * ordem de largura, um nível termina no maior índice de filho visto no nível
+ * anterior: basta uma passada, sem memória extra.
+ */
+static void medirMansao(const MansaoCompacta *mapa, Estatisticas *estatisticas) {
+    estatisticas->salas = mapa->quantidade;
+    estatisticas->profundidadeMansao = 0;
+    estatisticas->folhas = 0;
+
+    uint32_t fimDoNivel = 0;   // Última sala do nível atual
+    uint32_t maiorFilho = 0;   // Último filho visto (fim do próximo nível)
+    for (uint32_t i = 0; i < mapa->quantidade; i++) {
+        const SalaCompacta *sala = &mapa->salas[i];
+        if (sala->esquerda == SEM_SALA && sala->direita == SEM_SALA) {
+            estatisticas->folhas++;
+        }
+        if (sala->esquerda != SEM_SALA && sala->esquerda > maiorFilho) maiorFilho = sala->esquerda;
+        if (sala->direita != SEM_SALA && sala->direita > maiorFilho) maiorFilho = sala->direita;
+        if (i == fimDoNivel && maiorFilho > fimDoNivel) {
+            estatisticas->profundidadeMansao++;
+            fimDoNivel = maiorFilho;
+        }
+    }
+}
+
+// Vetores da tabela hash: posições, cadastro de suspeitos e listas do índice reverso
+static MemoriaEstrutura memoriaDaHash(const TabelaHash *tabela) {
+    MemoriaEstrutura memoria = { 0, 0 };
+    if (tabela->itens != NULL) {
+        memoria.bytes += (size_t)tabela->capacidade * sizeof(HashItem);
+        memoria.alocacoes++;
+    }
+    if (tabela->capacidadeSuspeitos > 0) {
+        memoria.bytes += (size_t)tabela->capacidadeSuspeitos * (sizeof(IdTexto) + sizeof(ListaPistas));
+        memoria.alocacoes += 2;
+    }
+    if (tabela->suspeitoDoTexto != NULL) {
+        memoria.bytes += (size_t)tabela->tamanhoSuspeitoDoTexto * sizeof(unsigned int);
+        memoria.alocacoes++;
+    }
+    if (tabela->pilotos != NULL) {
+        memoria.bytes += (size_t)tabela->numBaldes * sizeof(uint32_t);
+        memoria.alocacoes++;
+    }
+    if (tabela->filtro != NULL) {
+        memoria.bytes += (size_t)tabela->blocosFiltro * (BITS_BLOCO_FILTRO / 8);
+        memoria.alocacoes++;
+    }
+    for (unsigned int i = 0; i < tabela->numSuspeitos; i++) {
+        if (tabela->pistasDoSuspeito[i].pistas != NULL) {
+            memoria.bytes += (size_t)tabela->pistasDoSuspeito[i].capacidade * sizeof(IdTexto);
+            memoria.alocacoes++;
+        }
+    }
+    return memoria;
+}
+
+// Blob e vetores do conjunto de strings internadas
+static MemoriaEstrutura memoriaDosInternos(void) {
+    MemoriaEstrutura memoria = { 0, 0 };
+    if (internos.capacidadePosicoes != 0) {
+        memoria.bytes = internos.capacidadeBlob +
+                        internos.capacidadeIds * (sizeof(size_t) + sizeof(unsigned int) + sizeof(IdTexto)) +
+                        internos.capacidadePosicoes * sizeof(IdTexto);
+        memoria.alocacoes = 5;
+    }
+    return memoria;
+}
+
+// Vetores dos índices por texto: dois por chave coberta e um por sala com pista
+static MemoriaEstrutura memoriaDoIndiceSalas(const MansaoCompacta *mapa) {
+    MemoriaEstrutura memoria = { 0, 0 };
+    const IndiceSalas *indice = &mapa->indice;
+    if (indice->salaDoNome != NULL) {
+        memoria.bytes = ((size_t)2 * indice->tamanho + 4 + indice->inicioDaPista[indice->tamanho]) * sizeof(uint32_t);
+        memoria.alocacoes = 3;
+    }
+    return memoria;
+}
+
+// Vetores do índice de rotas: cinco por sala e a tabela esparsa dos blocos
+static MemoriaEstrutura memoriaDasRotas(const MansaoCompacta *mapa) {
+    MemoriaEstrutura memoria = { 0, 0 };
+    if (mapa->rotas.pais != NULL) {
+        memoria.bytes = ((size_t)5 * (mapa->quantidade + 1) +
+                         (size_t)mapa->rotas.niveis * mapa->rotas.numBlocos + 1) * sizeof(uint32_t);
+        memoria.alocacoes = 6;
+    }
+    return memoria;
+}
+
+/**
+ * Mede as estruturas do caso (tabelas, mansão e memória). As árvores de
+ * pistas entram antes, uma por investigação, com acumularInvestigacao.
+ */
+void medirCaso(const Caso *caso, Estatisticas *estatisticas) {
+    relatorioHash(&caso->associacoes, &estatisticas->associacoes);
+    relatorioInternos(&estatisticas->internados);
+    medirMansao(&caso->mapa, estatisticas);
+
+    MemoriaEstrutura arena = memoriaDaArena(&caso->arena);
+    MemoriaEstrutura montagem = memoriaDaArena(&caso->arenaMontagem);
+    arena.bytes += montagem.bytes;
+    arena.alocacoes += montagem.alocacoes;
+    if (arena.bytes > estatisticas->memoriaArena.bytes) {
+        estatisticas->memoriaArena = arena;
+    }
+    recolherContadoresFiltro();
+    estatisticas->filtro = totaisFiltro;
+    estatisticas->bitsFiltro = (unsigned long long)caso->associacoes.blocosFiltro * BITS_BLOCO_FILTRO;
+    estatisticas->funcoesFiltro = caso->associacoes.funcoesFiltro;
+    estatisticas->chavesFiltro = caso->associacoes.quantidade;
+    estatisticas->memoriaHash = memoriaDaHash(&caso->associacoes);
+    estatisticas->memoriaInternos = memoriaDosInternos();
+    estatisticas->memoriaMansao.bytes = (size_t)caso->mapa.quantidade * sizeof(SalaCompacta);
+    estatisticas->memoriaMansao.alocacoes = caso->mapa.salas != NULL ? 1 : 0;
+    estatisticas->memoriaRotas = memoriaDasRotas(&caso->mapa);
+    estatisticas->memoriaIndices = memoriaDoIndiceSalas(&caso->mapa);
+}
+
+static void imprimirMemoria(FILE *saida, const char *nome, MemoriaEstrutura memoria) {
+    fprintf(saida, "  %-20s %12zu bytes em %lu alocação(ões)\n", nome, memoria.bytes, memoria.alocacoes);
+}
+
+// Imprime o relatório completo de estatísticas
+void imprimirEstatisticas(FILE *saida, const Estatisticas *estatisticas) {
+    fprintf(saida, "\n=============== ESTATÍSTICAS ===============\n");
+    fprintf(saida, "Árvore de pistas: %lu nó(s) em %lu investigação(ões), altura máxima %u, profundidade média %.3f\n",
+            estatisticas->nosPistas, estatisticas->investigacoes, estatisticas->alturaMaximaPistas,
+            estatisticas->nosPistas ? (double)estatisticas->somaProfundidades / estatisticas->nosPistas : 0.0);
+    fprintf(saida, "Pistas já conhecidas coletadas de novo: %lu\n", estatisticas->pistasRepetidas);
+    imprimirRelatorioHash(saida, "", "Associações", &estatisticas->associacoes);
+    imprimirRelatorioHash(saida, "", "Textos internados", &estatisticas->internados);
+    if (estatisticas->bitsFiltro > 0) {
+        const ContadoresFiltro *filtro = &estatisticas->filtro;
+        unsigned long ausentes = filtro->rejeitadas + filtro->falsosPositivos;
+        fprintf(saida, "Filtro de Bloom: %llu bits (%.1f por chave), k = %u; %lu consulta(s), "
+                       "%lu descartada(s) sem sondar a tabela (%.1f%%), %lu falso(s) positivo(s) (%.3f%% das ausentes)\n",
+                estatisticas->bitsFiltro,
+                estatisticas->chavesFiltro ? (double)estatisticas->bitsFiltro / estatisticas->chavesFiltro : 0.0,
+                estatisticas->funcoesFiltro, filtro->consultas, filtro->rejeitadas,
+                filtro->consultas ? 100.0 * filtro->rejeitadas / filtro->consultas : 0.0,
+                filtro->falsosPositivos, ausentes ? 100.0 * filtro->falsosPositivos / ausentes : 0.0);
+    }
+    fprintf(saida, "Mansão: %u sala(s), profundidade %u, %u folha(s)\n",
+            estatisticas->salas, estatisticas->profundidadeMansao, estatisticas->folhas);
+    fprintf(saida, "Memória:\n");
+    imprimirMemoria(saida, "arena (pico)", estatisticas->memoriaArena);
+    imprimirMemoria(saida, "tabela hash", estatisticas->memoriaHash);
+    imprimirMemoria(saida, "textos internados", estatisticas->memoriaInternos);
+    imprimirMemoria(saida, "mansão compacta", estatisticas->memoriaMansao);
+    imprimirMemoria(saida, "índice de rotas", estatisticas->memoriaRotas);
+    imprimirMemoria(saida, "índices por texto", estatisticas->memoriaIndices);
+    MemoriaEstrutura total = {
+        estatisticas->memoriaArena.bytes + estatisticas->memoriaHash.bytes +
+            estatisticas->memoriaInternos.bytes + estatisticas->memoriaMansao.bytes +
+            estatisticas->memoriaRotas.bytes + estatisticas->memoriaIndices.bytes,
+        estatisticas->memoriaArena.alocacoes + estatisticas->memoriaHash.alocacoes +
+            estatisticas->memoriaInternos.alocacoes + estatisticas->memoriaMansao.alocacoes +
+            estatisticas->memoriaRotas.alocacoes + estatisticas->memoriaIndices.alocacoes
+    };
+    imprimirMemoria(saida, "total", total);
+}
+
+// --- 5. FUNÇÕES DO JOGO ---
+
+/**
+ * Lê o próximo comando (uma linha inteira) da fonte, sem espaços nas pontas.
+ * No modo interativo, descarrega a saída antes de esperar o jogador.
+ * Retorna 1 se leu uma linha ou 0 se a entrada acabou (fonte->fim passa a 1).
+ */
+static int lerComando(FonteComandos *fonte, char *linha, size_t tamanho) {
+    if (fonte->interativa) {
+        fflush(stdout);
+    }
+    if (fonte->fim || fgets(linha, (int)tamanho, fonte->arquivo) == NULL) {
+        fonte->fim = 1;
+        linha[0] = '\0';
+        return 0;
+    }
+
+    size_t fimTexto = strcspn(linha, "\r\n");
+    if (linha[fimTexto] == '\0' && fimTexto == tamanho - 1) {
+        // Linha maior que o buffer: descarta o restante
+        int c;
+        while ((c = fgetc(fonte->arquivo)) != '\n' && c != EOF);
+    }
+    while (fimTexto > 0 && isspace((unsigned char)linha[fimTexto - 1])) {
+        fimTexto--;
+    }
+    linha[fimTexto] = '\0';
+
+    size_t inicio = 0;
+    while (isspace((unsigned char)linha[inicio])) {
+        inicio++;
+    }
+    if (inicio > 0) {
+        memmove(linha, linha + inicio, fimTexto - inicio + 1);
+    }
+    return 1;
+}
+
+/**
+ * Começa uma investigação sem pistas, com todos os contadores de evidência zerados.
+ * Os contadores são alocados na arena, junto com as pistas que virão.
+ */
+static void iniciarInvestigacao(Investigacao *investigacao, Arena *arena, const TabelaHash *tabelaHash) {
+    unsigned int n = tabelaHash->numSuspeitos;
+    investigacao->arena = arena;
+    investigacao->pistas = NULL;
+    investigacao->pistasRepetidas = 0;
+    investigacao->sala = 0;
+    investigacao->explorada = 0;
+    investigacao->numSuspeitos = n;
+    investigacao->evidencias = (unsigned int*)alocarNaArena(arena, (n + 1) * sizeof(unsigned int));
+    investigacao->ordem = (unsigned int*)alocarNaArena(arena, (n + 1) * sizeof(unsigned int));
+    investigacao->posicao = (unsigned int*)alocarNaArena(arena, (n + 1) * sizeof(unsigned int));
+    memset(investigacao->evidencias, 0, (n + 1) * sizeof(unsigned int));
+    for (unsigned int i = 0; i < n; i++) {
+        investigacao->ordem[i] = i;
+        investigacao->posicao[i] = i;
+    }
+    investigacao->coletadasContra = (EvidenciaColetada**)alocarNaArena(arena, (n + 1) * sizeof(EvidenciaColetada*));
+    for (unsigned int i = 0; i < n; i++) {
+        investigacao->coletadasContra[i] = NULL;
+    }
+    investigacao->tamanhoAcima = 16;
+    investigacao->acima = (unsigned int*)alocarNaArena(arena, investigacao->tamanhoAcima * sizeof(unsigned int));
+    memset(investigacao->acima, 0, investigacao->tamanhoAcima * sizeof(unsigned int));
+}
+
+/**
+ * Soma uma evidência contra um suspeito mantendo o ranking ordenado.
+ * O suspeito troca de lugar com o primeiro do grupo que tem a mesma contagem;
+ * esse grupo passa então a começar uma posição adiante.
+ */
+static void incrementarEvidencia(Investigacao *investigacao, unsigned int suspeito) {
+    unsigned int contagem = investigacao->evidencias[suspeito];
+
+    if (contagem + 1 >= investigacao->tamanhoAcima) {
+        // Dobra o vetor na arena; as contagens novas ainda não têm ninguém acima
+        unsigned int novoTamanho = investigacao->tamanhoAcima * 2;
+        unsigned int *novo = (unsigned int*)alocarNaArena(investigacao->arena, novoTamanho * sizeof(unsigned int));
+        memcpy(novo, investigacao->acima, investigacao->tamanhoAcima * sizeof(unsigned int));
+        memset(novo + investigacao->tamanhoAcima, 0, (novoTamanho - investigacao->tamanhoAcima) * sizeof(unsigned int));
+        investigacao->acima = novo;
+        investigacao->tamanhoAcima = novoTamanho;
+    }
+
+    unsigned int primeira = investigacao->acima[contagem];
+    unsigned int atual = investigacao->posicao[suspeito];
+    unsigned int outro = investigacao->ordem[primeira];
+
+    investigacao->ordem[atual] = outro;
+    investigacao->posicao[outro] = atual;
+    investigacao->ordem[primeira] = suspeito;
+    investigacao->posicao[suspeito] = primeira;
+
+    investigacao->acima[contagem]++;
+    investigacao->evidencias[suspeito] = contagem + 1;
+}
+
+/**
+ * Preenche 'suspeitos' com até k números de suspeitos, do mais citado para o
+ * menos citado, ignorando quem não tem nenhuma evidência. Custa O(k).
+ * Retorna quantos suspeitos foram escritos.
+ */
+static unsigned int rankingSuspeitos(const Investigacao *investigacao, unsigned int k, unsigned int *suspeitos) {
+    unsigned int comEvidencia = investigacao->acima[0]; // Suspeitos com mais de 0 evidências
+    if (k > comEvidencia) {
+        k = comEvidencia;
+    }
+    memcpy(suspeitos, investigacao->ordem, k * sizeof(unsigned int));
+    return k;
+}
+
+// Soma a evidência de uma pista recém-coletada contra o seu suspeito (se ela tiver um)
+static void anotarEvidencia(Investigacao *investigacao, TabelaHash *tabelaHash, IdTexto pista) {
+    HashItem *associacao = buscarItem(tabelaHash, pista);
+    if (associacao != NULL) {
+        unsigned int suspeito = associacao->indiceSuspeito;
+        EvidenciaColetada *evidencia = (EvidenciaColetada*)alocarNaArena(investigacao->arena, sizeof(EvidenciaColetada));
+        evidencia->pista = pista;
+        evidencia->anterior = investigacao->coletadasContra[suspeito];
+        investigacao->coletadasContra[suspeito] = evidencia;
+        incrementarEvidencia(investigacao, suspeito);
+    }
+}
+
+/**
+ * Registra uma pista coletada: insere na AVL e, se ela for nova e tiver
+ * suspeito associado, soma uma evidência contra ele.
+ * Retorna 1 se a pista era nova ou 0 se já havia sido coletada.
+ */
+static int coletarPista(Investigacao *investigacao, TabelaHash *tabelaHash, IdTexto pista) {
+    int inserida;
+    investigacao->pistas = inserirPista(investigacao->arena, investigacao->pistas, pista, &inserida);
+    if (inserida) {
+        anotarEvidencia(investigacao, tabelaHash, pista);
+    } else {
+        investigacao->pistasRepetidas++;
+    }
+    return inserida;
+}
+
+/**
+ * Pistas já coletadas pelo jogador que apontam para o suspeito com esse nome,
+ * da mais recente para a mais antiga. Percorrer a lista custa o tamanho da resposta.
+ * Retorna NULL se nenhuma pista coletada aponta para ele.
+ */
+static const EvidenciaColetada* evidenciasColetadasContra(const Investigacao *investigacao, const TabelaHash *tabelaHash, IdTexto idSuspeito) {
+    unsigned int suspeito = procurarSuspeito(tabelaHash, idSuspeito);
+    return suspeito != SEM_SUSPEITO ? investigacao->coletadasContra[suspeito] : NULL;
+}
+
+// Pistas coletadas que apontam para o suspeito com esse nome (leitura O(1))
+static unsigned int evidenciasContra(const Investigacao *investigacao, const TabelaHash *tabelaHash, IdTexto idAcusado) {
+    unsigned int suspeito = procurarSuspeito(tabelaHash, idAcusado);
+    return suspeito != SEM_SUSPEITO ? investigacao->evidencias[suspeito] : 0;
+}
+
+// Se a linha é o comando 'nome' (com ou sem argumento, maiúsculas ou não),
+// devolve o argumento sem os espaços da frente; caso contrário, NULL
+static const char* argumentoDoComando(const char *linha, const char *nome) {
+    size_t tamanho = strlen(nome);
+    if (strncasecmp(linha, nome, tamanho) != 0 ||
+        (linha[tamanho] != '\0' && !isspace((unsigned char)linha[tamanho]))) {
+        return NULL;
+    }
+    linha += tamanho;
+    while (isspace((unsigned char)*linha)) {
+        linha++;
+    }
+    return linha;
+}
+
+// Comando 'rota <sala>': mostra os movimentos da sala atual até a sala pedida
+static void mostrarRota(const MansaoCompacta *mapa, uint32_t atual, const char *nome) {
+    if (nivelLog < NIVEL_INFO) {
+        return; // Só narração: sem ninguém lendo, não há o que calcular
+    }
+    if (*nome == '\0') {
+        printf(" Diga para qual sala: rota <nome da sala>.\n");
+        return;
+    }
+    uint32_t destino = procurarSala(mapa, nome);
+    if (destino == SEM_SALA) {
+        printf(" Não há nenhuma sala chamada '%s' nesta mansão.\n", nome);
+        return;
+    }
+    size_t total = rotaNaMansao(mapa, atual, destino, NULL, 0);
+    if (total == 0) {
+        printf(" Você já está em **%s**.\n", textoDoId(mapa->salas[destino].nome));
+        return;
+    }
+    char *passos = (char*)malloc(total + 1);
+    if (passos == NULL) {
+        perror("Erro de alocação de memória para a rota");
+        exit(EXIT_FAILURE);
+    }
+    rotaNaMansao(mapa, atual, destino, passos, total + 1);
+    printf(" Rota até **%s** (%zu movimento(s)):", textoDoId(mapa->salas[destino].nome), total);
+    for (size_t i = 0; i < total; i++) {
+        printf(" %c", passos[i]);
+    }
+    printf("\n");
+    free(passos);
+}
+
+// Comando 'onde <pista>': mostra as salas que têm a pista e a distância até cada uma
+static void mostrarPista(const MansaoCompacta *mapa, uint32_t atual, const char *pista) {
+    if (nivelLog < NIVEL_INFO) {
+        return;
+    }
+    if (*pista == '\0') {
+        printf(" Diga qual pista: onde <pista>.\n");
+        return;
+    }
+    const uint32_t *salas;
+    uint32_t quantas = procurarPista(mapa, pista, &salas);
+    if (quantas == 0) {
+        printf(" A pista '%s' não está em nenhuma sala desta mansão.\n", pista);
+        return;
+    }
+    printf(" A pista **%s** está em %u sala(s):\n", textoDoId(mapa->salas[salas[0]].pista), quantas);
+    uint32_t mostradas = quantas < SALAS_MOSTRADAS_PISTA ? quantas : SALAS_MOSTRADAS_PISTA;
+    for (uint32_t i = 0; i < mostradas; i++) {
+        printf("   - %s (%zu movimento(s) daqui)\n", textoDoId(mapa->salas[salas[i]].nome),
+               rotaNaMansao(mapa, atual, salas[i], NULL, 0));
+    }
+    if (quantas > mostradas) {
+        printf("   ... e mais %u.\n", quantas - mostradas);
+    }
+}
+
+/**
+ * Função principal para navegação e interação do jogador na mansão.
+ * A mansão congelada; a exploração começa no Hall (sala 0).
+ * O ponteiro para a Tabela Hash de associações Pista/Suspeito.
+ * A investigação que recebe as pistas encontradas e os contadores de evidência.
+ * A fonte dos comandos (teclado ou roteiro); o fim da entrada encerra a exploração.
+ * A exploração começa na sala guardada na investigação e a mantém atualizada.
+ * Chegando, 1 se o jogador acaba de entrar nessa sala; 0 ao retomar uma sessão ou
+ * voltar de uma pausa (a pista dela já foi coletada e não conta como repetida).
+ * Retorna 1 se o jogador pausou a investigação ('p') ou 0 nos demais casos.
+ */
+static int explorarSalas(const MansaoCompacta *mapa, TabelaHash *tabelaHash, Investigacao *investigacao,
+                         FonteComandos *fonte, int chegando) {
+    char acao[TAMANHO_LINHA_COMANDO];
+    uint32_t indiceAtual = investigacao->sala < mapa->quantidade ? investigacao->sala : SEM_SALA;
+    uint32_t indiceAnterior = SEM_SALA; // Sala já narrada: comandos que não movem não coletam de novo
+    // Cada medida vai de um comando lido (ou da entrada no Hall) até o próximo pedido de comando
+    uint64_t inicio = INICIAR_MEDIDA();
+
+    while (indiceAtual != SEM_SALA) {
+        const SalaCompacta *atual = &mapa->salas[indiceAtual];
+
+        // 1. Coleta da Pista (só ao entrar na sala)
+        if (indiceAtual != indiceAnterior) {
+            SAIDA("\n--- Você está no cômodo: **%s** ---\n", textoDoId(atual->nome));
+            if (!chegando && atual->pista != TEXTO_VAZIO) {
+                SAIDA(" A pista deste cômodo já está com você.\n");
+            } else if (atual->pista != TEXTO_VAZIO) {
+                SAIDA(" Você encontrou uma pista: **%s**\n", textoDoId(atual->pista));
+                
+                // Insere na AVL (Árvore de Pistas) e atualiza as evidências
+                if (coletarPista(investigacao, tabelaHash, atual->pista)) {
+                    // A inserção real (não duplicada) ocorreu
+                    SAIDA(" Pista coletada e registrada.\n");
+                } else {
+                    SAIDA(" Pista já havia sido coletada.\n");
+                }
+            } else {
+                SAIDA("O cômodo parece estar limpo. Nenhuma pista visível aqui.\n");
+            }
+            indiceAnterior = indiceAtual;
+            chegando = 1;
+        }
+
+        // 2. Escolha de Navegação
+        SAIDA("\nPara onde deseja ir? **(e)**squerda, **(d)**ireita, **(v)**oltar, **(p)**ausar ou **(s)**air da exploração\n"
+              "(ou 'ir <sala>', 'rota <sala>' para ver o caminho até ela, 'onde <pista>'): ");
+        TERMINAR_MEDIDA(FASE_COMANDO, inicio);
+        if (!lerComando(fonte, acao, sizeof(acao))) {
+            SAIDA("\nFim da entrada. Encerrando a exploração...\n");
+            return 0;
+        }
+        inicio = INICIAR_MEDIDA();
+
+        char escolha = tolower((unsigned char)acao[0]);
+
+        const char *argumento;
+
+        if ((argumento = argumentoDoComando(acao, "rota")) != NULL) {
+            mostrarRota(mapa, indiceAtual, argumento);
+        } else if ((argumento = argumentoDoComando(acao, "onde")) != NULL) {
+            mostrarPista(mapa, indiceAtual, argumento);
+        } else if ((argumento = argumentoDoComando(acao, "ir")) != NULL) {
+            uint32_t destino = procurarSala(mapa, argumento);
+            if (destino != SEM_SALA) {
+                indiceAtual = destino;
+            } else {
+                SAIDA(" Não há nenhuma sala chamada '%s' nesta mansão.\n", argumento);
+            }
+        } else if (escolha == 's') {
+            SAIDA("\nFim da exploração. Preparando para a fase de julgamento...\n");
+            investigacao->explorada = 1;
+            TERMINAR_MEDIDA(FASE_COMANDO, inicio);
+            return 0;
+        } else if (escolha == 'p') {
+            SAIDA("\nInvestigação pausada.\n");
+            TERMINAR_MEDIDA(FASE_COMANDO, inicio);
+            return 1;
+        } else if (escolha == 'e') {
+            if (atual->esquerda != SEM_SALA) {
+                indiceAtual = atual->esquerda;
+            } else {
+                SAIDA(" Não há saída para a esquerda neste cômodo. Tente outra direção.\n");
+            }
+        } else if (escolha == 'd') {
+            if (atual->direita != SEM_SALA) {
+                indiceAtual = atual->direita;
+            } else {
+                SAIDA(" Não há saída para a direita neste cômodo. Tente outra direção.\n");
+            }
+        } else if (escolha == 'v') {
+            if (mapa->rotas.pais[indiceAtual] != SEM_SALA) {
+                indiceAtual = mapa->rotas.pais[indiceAtual];
+            } else {
+                SAIDA(" Você está no Hall de Entrada: não há para onde voltar.\n");
+            }
+        } else {
+            SAIDA("Opção inválida. Digite 'e', 'd', 'v', 'p', 's', 'ir <sala>', 'rota <sala>' ou 'onde <pista>'.\n");
+        }
+        investigacao->sala = indiceAtual;
+    }
+    return 0;
+}
+
+// Empilha o nó e toda a sua descida pela esquerda
+static void descerEsquerda(PercursoPistas *percurso, const NoPista *no) {
+    for (; no != NULL; no = no->esquerda) {
+        percurso->pilha[percurso->topo++] = no;
+    }
+}
+
+// Começa um percurso em ordem pela árvore de pistas
+static void iniciarPercurso(PercursoPistas *percurso, const NoPista *raiz) {
+    percurso->topo = 0;
+    descerEsquerda(percurso, raiz);
+}
+
+// Próxima pista em ordem alfabética, ou NULL no fim do percurso
+static const NoPista* proximaPista(PercursoPistas *percurso) {
+    if (percurso->topo == 0) {
+        return NULL;
+    }
+    const NoPista *no = percurso->pilha[--percurso->topo];
+    descerEsquerda(percurso, no->direita);
+    return no;
+}
+
+// Função auxiliar para listar as pistas (In-Order Traversal da AVL, sem recursão)
+static void listarPistas(NoPista *raiz) {
+    PercursoPistas percurso;
+    iniciarPercurso(&percurso, raiz);
+    for (const NoPista *no = proximaPista(&percurso); no != NULL; no = proximaPista(&percurso)) {
+        printf("- %s\n", textoDoId(no->pista));
+    }
+}
+
+/**
+ * Conta, percorrendo a árvore, quantas pistas coletadas apontam para o acusado.
+ * É a contagem de referência; o jogo usa os contadores incrementais da
+ * Investigacao e o índice de evidências coletadas por suspeito.
+ */
+static int contarPistas(NoPista *raiz, TabelaHash *tabelaHash, IdTexto idAcusado, int listar) {
+    if (idAcusado == TEXTO_INEXISTENTE) {
+        return 0;
+    }
+    IdTexto chaveAcusado = chaveDoId(idAcusado);
+    int contagem = 0;
+
+    PercursoPistas percurso;
+    iniciarPercurso(&percurso, raiz);
+    for (const NoPista *no = proximaPista(&percurso); no != NULL; no = proximaPista(&percurso)) {
+        IdTexto suspeitoDaPista = encontrarSuspeitoId(tabelaHash, no->pista);
+        if (suspeitoDaPista != TEXTO_INEXISTENTE && chaveDoId(suspeitoDaPista) == chaveAcusado) {
+            contagem++;
+            if (listar) {
+                printf("   [+] Pista '%s' aponta para %s.\n", textoDoId(no->pista), textoDoId(idAcusado));
+            }
+        }
+    }
+    return contagem;
+}
+
+/**
+ * Achata a árvore de pistas num vetor, em ordem alfabética.
+ * Quantidade, recebe o número de pistas. O vetor deve ser liberado com free.
+ */
+static IdTexto* achatarPistas(const NoPista *raiz, size_t *quantidade) {
+    size_t capacidade = 1024, n = 0;
+    IdTexto *pistas = (IdTexto*)malloc(capacidade * sizeof(IdTexto));
+    if (pistas == NULL) {
+        perror("Erro de alocação de memória para as pistas achatadas");
+        exit(EXIT_FAILURE);
+    }
+    PercursoPistas percurso;
+    iniciarPercurso(&percurso, raiz);
+    for (const NoPista *no = proximaPista(&percurso); no != NULL; no = proximaPista(&percurso)) {
+        if (n == capacidade) {
+            capacidade *= 2;
+            pistas = (IdTexto*)realloc(pistas, capacidade * sizeof(IdTexto));
+            if (pistas == NULL) {
+                perror("Erro de alocação de memória para as pistas achatadas");
+                exit(EXIT_FAILURE);
+            }
+        }
+        pistas[n++] = no->pista;
+    }
+    *quantidade = n;
+    return pistas;
+}
+
+// Conta num vetor próprio (numSuspeitos posições) os lotes que conseguir pegar
+static void reduzirLotes(ReducaoEvidencias *reducao, unsigned long *contagens) {
+    while (1) {
+        size_t inicio = atomic_fetch_add_explicit(&reducao->proximoLote, TAMANHO_LOTE_REDUCAO, memory_order_relaxed);
+        if (inicio >= reducao->quantidade) {
+            return;
+        }
+        size_t fim = inicio + TAMANHO_LOTE_REDUCAO < reducao->quantidade ? inicio + TAMANHO_LOTE_REDUCAO : reducao->quantidade;
+        for (size_t i = inicio; i < fim; i++) {
+            const HashItem *item = buscarItem(reducao->tabela, reducao->pistas[i]);
+            if (item != NULL) {
+                contagens[item->indiceSuspeito]++;
+            }
+        }
+    }
+}
+
+typedef struct TrabalhoReducao {
+    ReducaoEvidencias *reducao;
+    unsigned long *contagens;
+} TrabalhoReducao;
+
+static void* trabalhadorReducao(void *argumento) {
+    TrabalhoReducao *trabalho = (TrabalhoReducao*)argumento;
+    reduzirLotes(trabalho->reducao, trabalho->contagens);
+    recolherContadoresFiltro();
+    return NULL;
+}
+
+/**
+ * Conta, para cada suspeito, as pistas coletadas que apontam para ele,
+ * dividindo o trabalho entre 'trabalhadores' threads (a chamadora é uma delas).
+ * Lotes pequenos e distribuídos sob demanda mantêm todos ocupados mesmo
+ * quando algumas pistas custam mais para resolver.
+ * Contagens, recebe tabela->numSuspeitos posições (número do suspeito -> pistas).
+ */
+static void reduzirEvidenciasParalelo(const IdTexto *pistas, size_t quantidade, TabelaHash *tabela,
+                               unsigned int trabalhadores, unsigned long *contagens) {
+    unsigned int n = tabela->numSuspeitos;
+    if (trabalhadores < 1) trabalhadores = 1;
+    if (trabalhadores > MAXIMO_TRABALHADORES) trabalhadores = MAXIMO_TRABALHADORES;
+
+    ReducaoEvidencias reducao;
+    reducao.pistas = pistas;
+    reducao.quantidade = quantidade;
+    reducao.tabela = tabela;
+    atomic_init(&reducao.proximoLote, 0);
+
+    // Um vetor de contagens por trabalhador: nenhuma escrita compartilhada no laço
+    unsigned long *parciais = (unsigned long*)calloc((size_t)trabalhadores * (n + 1), sizeof(unsigned long));
+    if (parciais == NULL) {
+        perror("Erro de alocação de memória para a redução paralela");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t threads[MAXIMO_TRABALHADORES];
+    TrabalhoReducao trabalhos[MAXIMO_TRABALHADORES];
+    unsigned int iniciadas = 0;
+    for (unsigned int t = 1; t < trabalhadores; t++) {
+        trabalhos[t].reducao = &reducao;
+        trabalhos[t].contagens = parciais + (size_t)t * (n + 1);
+        if (pthread_create(&threads[t], NULL, trabalhadorReducao, &trabalhos[t]) != 0) {
+            break; // Os lotes que sobrarem ficam com quem já está rodando
+        }
+        iniciadas = t;
+    }
+    reduzirLotes(&reducao, parciais);
+    for (unsigned int t = 1; t <= iniciadas; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    for (unsigned int s = 0; s < n; s++) {
+        unsigned long soma = 0;
+        for (unsigned int t = 0; t <= iniciadas; t++) {
+            soma += parciais[(size_t)t * (n + 1) + s];
+        }
+        contagens[s] = soma;
+    }
+    free(parciais);
+}
+
+/**
+ * Conduz à fase de julgamento final.
+ * A contagem de pistas contra o acusado vem pronta dos contadores da investigação.
+ * A investigação com as pistas que o jogador encontrou.
+ * O ponteiro para a Tabela Hash de associações Pista/Suspeito.
+ * A fonte de onde vem o nome do acusado (uma linha).
+ * Veredito, recebe o acusado, a contagem e o resultado.
+ * Retorna 1 se houve acusação ou 0 se a entrada acabou antes dela.
+ */
+static int verificarSuspeitoFinal(const Investigacao *investigacao, TabelaHash *tabelaHash, FonteComandos *fonte, Veredito *veredito) {
+    char *acusado = veredito->acusado;
+    uint64_t inicio = INICIAR_MEDIDA();
+
+    SAIDA("\n\n=============== FASE DE JULGAMENTO ==============\n");
+
+    if (investigacao->pistas == NULL) {
+        SAIDA(" Você não coletou nenhuma pista. A acusação será apenas um palpite!\n");
+    } else if (nivelLog >= NIVEL_INFO) {
+        printf(" Pistas coletadas (em ordem alfabética):\n");
+        listarPistas(investigacao->pistas);
+
+        unsigned int ranking[TAMANHO_RANKING];
+        unsigned int quantos = rankingSuspeitos(investigacao, TAMANHO_RANKING, ranking);
+        if (quantos > 0) {
+            printf("\n Suspeitos mais citados pelas pistas:\n");
+            for (unsigned int i = 0; i < quantos; i++) {
+                printf("   %u. %s (%u)\n", i + 1, textoDoId(tabelaHash->suspeitos[ranking[i]]),
+                       investigacao->evidencias[ranking[i]]);
+            }
+        }
+    }
+    
+    SAIDA("\nCom base nas evidências, quem você acusa? (Digite o nome do suspeito): ");
+    if (!lerComando(fonte, acusado, sizeof(veredito->acusado))) {
+        SAIDA("\nNenhuma acusação foi feita.\n");
+        TERMINAR_MEDIDA(FASE_JULGAMENTO, inicio);
+        return 0;
+    }
+
+    SAIDA("\nAnalisando as evidências coletadas contra **%s**...\n", acusado);
+
+    // Um nome sem nenhuma grafia internada não pode ser suspeito de nenhuma pista
+    IdTexto idAcusado = buscarChave(acusado);
+    int contagemPistas = (int)evidenciasContra(investigacao, tabelaHash, idAcusado);
+
+    if (nivelLog >= NIVEL_INFO) {
+        const IdTexto *todas;
+        unsigned int totalDoCaso = pistasDoSuspeito(tabelaHash, idAcusado, &todas);
+        const EvidenciaColetada *evidencia = evidenciasColetadasContra(investigacao, tabelaHash, idAcusado);
+        for (; evidencia != NULL; evidencia = evidencia->anterior) {
+            printf("   [+] Pista '%s' aponta para %s.\n", textoDoId(evidencia->pista), acusado);
+        }
+        printf("   (O caso tem %u pista(s) ligadas a %s.)\n", totalDoCaso, acusado);
+    }
+
+    veredito->pistas = contagemPistas;
+    veredito->sucesso = contagemPistas >= PISTAS_PARA_CONDENAR;
+
+    SAIDA("\n--- RESULTADO DA ANÁLISE ---\n");
+    SAIDA("Número total de pistas contra %s: **%d**\n", acusado, contagemPistas);
+
+    if (veredito->sucesso) {
+        SAIDA("\n SUCESSO! **%s** foi formalmente acusado!\n", acusado);
+        SAIDA("Pelo menos duas pistas substanciais (%d) sustentam a sua conclusão. Caso resolvido!\n", contagemPistas);
+    } else {
+        SAIDA("\n FRACASSO! A acusação contra **%s** não pode ser sustentada.\n", acusado);
+        SAIDA("Você precisa de, pelo menos, 2 pistas. A falta de evidências substanciais leva à absolvição.\n");
+    }
+    TERMINAR_MEDIDA(FASE_JULGAMENTO, inicio);
+    return 1;
+}
+
+/**
+ * Reproduz sessões de um roteiro sem interação, uma atrás da outra.
+ * Cada sessão começa no Hall com nenhuma pista; os comandos são uma linha cada
+ * ('e', 'd', ...) até 's', e a linha seguinte é o nome do acusado.
+ * Para cada sessão, escreve uma linha legível por máquina:
+ *   VEREDITO<TAB>sessão<TAB>acusado<TAB>pistas<TAB>SUCESSO|FRACASSO
+ * As pistas de cada sessão saem da arena recebida e voltam para ela ao final
+ * da sessão; o caso em si só é lido (várias threads podem usá-lo ao mesmo tempo).
+ * Saida, recebe as linhas VEREDITO.
+ * Estatisticas, se não for NULL, acumula cada sessão antes de a arena ser restaurada.
+ * Retorna o número de sessões reproduzidas.
+ */
+static unsigned long reproduzirRoteiro(Caso *caso, Arena *arena, FonteComandos *fonte, FILE *saida, Estatisticas *estatisticas) {
+    unsigned long sessoes = 0;
+
+    while (!fonte->fim) {
+        uint64_t inicio = INICIAR_MEDIDA();
+        MarcaArena marca = marcarArena(arena);
+        Investigacao investigacao;
+        Veredito veredito;
+
+        iniciarInvestigacao(&investigacao, arena, &caso->associacoes);
+        int pausada = explorarSalas(&caso->mapa, &caso->associacoes, &investigacao, fonte, 1);
+        while (pausada) {
+            SAIDA(" Não há como guardar a investigação no modo roteiro; a exploração continua.\n");
+            pausada = explorarSalas(&caso->mapa, &caso->associacoes, &investigacao, fonte, 0);
+        }
+        if (verificarSuspeitoFinal(&investigacao, &caso->associacoes, fonte, &veredito)) {
+            sessoes++;
+            fprintf(saida, "VEREDITO\t%lu\t%s\t%d\t%s\n", sessoes, veredito.acusado, veredito.pistas,
+                   veredito.sucesso ? "SUCESSO" : "FRACASSO");
+            if (estatisticas != NULL) {
+                acumularInvestigacao(estatisticas, &investigacao);
+            }
+        }
+
+        restaurarArena(arena, marca);
+        TERMINAR_MEDIDA(FASE_SESSAO, inicio);
+    }
+    return sessoes;
+}
+
+/**
+ * Modo varredura: um "jogador" automático visita todas as salas da mansão,
+ * coleta todas as pistas e conta as evidências com a redução paralela.
+ * O resultado de cada suspeito é conferido com os contadores incrementais e
+ * com o contarPistas sequencial, cronometrado à parte. Escreve em stdout uma
+ * linha SUSPEITO por suspeito, do mais citado ao menos citado, e uma linha final
+ *   VARREDURA<TAB>salas<TAB>pistas<TAB>OK|DIVERGENCIA
+ * Retorna 0 se as contagens bateram ou -1 caso contrário.
+ */
+int executarVarredura(Caso *caso, unsigned int trabalhadores) {
+    MarcaArena marca = marcarArena(&caso->arena);
+    Investigacao investigacao;
+    iniciarInvestigacao(&investigacao, &caso->arena, &caso->associacoes);
+    for (uint32_t i = 0; i < caso->mapa.quantidade; i++) {
+        if (caso->mapa.salas[i].pista != TEXTO_VAZIO) {
+            coletarPista(&investigacao, &caso->associacoes, caso->mapa.salas[i].pista);
+        }
+    }
+
+    size_t quantidade;
+    IdTexto *pistas = achatarPistas(investigacao.pistas, &quantidade);
+    unsigned int n = caso->associacoes.numSuspeitos;
+    unsigned long *contagens = (unsigned long*)malloc((n + 1) * sizeof(unsigned long));
+    if (contagens == NULL) {
+        perror("Erro de alocação de memória para a varredura");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t inicio = relogioNs();
+    reduzirEvidenciasParalelo(pistas, quantidade, &caso->associacoes, trabalhadores, contagens);
+    uint64_t duracao = relogioNs() - inicio;
+
+    int confere = 1;
+    for (unsigned int s = 0; s < n; s++) {
+        if (contagens[s] != investigacao.evidencias[s]) {
+            confere = 0;
+        }
+    }
+    uint64_t inicioSequencial = relogioNs();
+    for (unsigned int s = 0; s < n; s++) {
+        IdTexto nome = caso->associacoes.suspeitos[s];
+        if ((unsigned long)contarPistas(investigacao.pistas, &caso->associacoes, nome, 0) != contagens[s]) {
+            confere = 0;
+        }
+    }
+    uint64_t duracaoSequencial = relogioNs() - inicioSequencial;
+
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int suspeito = investigacao.ordem[i];
+        printf("SUSPEITO\t%s\t%lu\n", textoDoId(caso->associacoes.suspeitos[suspeito]), contagens[suspeito]);
+    }
+    printf("VARREDURA\t%u\t%zu\t%s\n", caso->mapa.quantidade, quantidade, confere ? "OK" : "DIVERGENCIA");
+    fflush(stdout);
+    fprintf(stderr, "Redução paralela (%u trabalhador(es)): %.3f ms para todos os suspeitos; "
+                    "contarPistas sequencial: %.3f ms para os %u suspeito(s).\n",
+            trabalhadores, duracao / 1e6, duracaoSequencial / 1e6, n);
+
+    free(contagens);
+    free(pistas);
+    restaurarArena(&caso->arena, marca);
+    return confere ? 0 : -1;
+}
+
+/*
+ * Formato de sessão salva (.dqs), inteiros em little-endian:
+ *
+ *   "DQS1"  u32 impressaoBaixa  u32 impressaoAlta   (identificam o caso da sessão)
+ *           u32 sala  u32 estado (bit 0 = exploração encerrada)
+ *           u32 pistasRepetidas  u32 numPistas
+ *   numPistas x { u16 tamPista  pista }         (na ordem da árvore de pistas)
+ *
+ * As pistas vão como texto porque os ids internados mudam de um processo para
+ * outro. Como já estão em ordem, a volta monta a AVL em O(n), sem comparações;
+ * os contadores de evidência e o ranking são refeitos pelas associações.
+ */
+
+// FNV-1a de 64 bits continuado a partir de 'h', com o '\0' final separando os textos
+static uint64_t continuarFnv64(uint64_t h, const char *texto) {
+    const unsigned char *p = (const unsigned char*)texto;
+    do {
+        h ^= *p;
+        h *= 0x100000001B3ULL;
+    } while (*p++ != '\0');
+    return h;
+}
+
+/**
+ * Impressão digital do caso gravada nas sessões: os nomes, pistas e ligações
+ * das salas na ordem da mansão compacta (a mesma dos índices gravados), mais a
+ * soma das associações, cuja ordem na tabela depende da função de hash.
+ * Não depende da ordem de bytes da máquina.
+ */
+static uint64_t impressaoDoCaso(const Caso *caso) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (uint32_t i = 0; i < caso->mapa.quantidade; i++) {
+        const SalaCompacta *sala = &caso->mapa.salas[i];
+        h = continuarFnv64(h, textoDoId(sala->nome));
+        h = continuarFnv64(h, textoDoId(sala->pista));
+        h = (h ^ sala->esquerda) * 0x100000001B3ULL;
+        h = (h ^ sala->direita) * 0x100000001B3ULL;
+    }
+    uint64_t associacoes = 0;
+    for (unsigned int i = 0; i < caso->associacoes.capacidade; i++) {
+        const HashItem *item = &caso->associacoes.itens[i];
+        if (item->distancia != 0) {
+            uint64_t a = continuarFnv64(0xCBF29CE484222325ULL, textoDoId(item->pista));
+            associacoes += continuarFnv64(a, textoDoId(caso->associacoes.suspeitos[item->indiceSuspeito]));
+        }
+    }
+    return finalizar64(h ^ associacoes);
+}
+
+/**
+ * Grava o estado de uma investigação em andamento: pistas, sala atual e fase.
+ * Retorna 0 em caso de sucesso ou -1 em caso de erro.
+ */
+static int salvarSessao(const Caso *caso, const Investigacao *investigacao, const char *caminho) {
+    FILE *arquivo = fopen(caminho, "wb");
+    if (arquivo == NULL) {
+        perror(caminho);
+        return -1;
+    }
+    size_t quantidade;
+    IdTexto *pistas = achatarPistas(investigacao->pistas, &quantidade);
+    unsigned long repetidas = investigacao->pistasRepetidas;
+
+    uint64_t impressao = impressaoDoCaso(caso);
+    fwrite(MAGICO_SESSAO, 1, 4, arquivo);
+    gravarU32(arquivo, (uint32_t)impressao);
+    gravarU32(arquivo, (uint32_t)(impressao >> 32));
+    gravarU32(arquivo, investigacao->sala);
+    gravarU32(arquivo, investigacao->explorada ? 1u : 0u);
+    gravarU32(arquivo, repetidas > 0xFFFFFFFFul ? 0xFFFFFFFFu : (uint32_t)repetidas);
+    gravarU32(arquivo, (uint32_t)quantidade);
+    int textoLongo = 0;
+    for (size_t i = 0; i < quantidade && !textoLongo; i++) {
+        textoLongo = gravarTextoCurto(arquivo, pistas[i]) != 0;
+    }
+    free(pistas);
+
+    int resultado = ferror(arquivo) || textoLongo ? -1 : 0;
+    if (fclose(arquivo) != 0) {
+        resultado = -1;
+    }
+    if (textoLongo) {
+        fprintf(stderr, "%s: texto com mais de %u bytes não cabe no formato da sessão.\n", caminho, TAMANHO_MAXIMO_TEXTO);
+    } else if (resultado != 0) {
+        fprintf(stderr, "%s: erro ao gravar a sessão.\n", caminho);
+    }
+    if (resultado != 0) {
+        remove(caminho);
+    }
+    return resultado;
+}
+
+/**
+ * Retoma uma investigação gravada por salvarSessao para o mesmo caso.
+ * Os nós e contadores saem da arena recebida, como em iniciarInvestigacao.
+ * Retorna 0 em caso de sucesso ou -1 se o arquivo for inválido ou de outro caso
+ * (nesse caso a investigação não é tocada).
+ */
+static int carregarSessao(Caso *caso, Arena *arena, Investigacao *investigacao, const char *caminho) {
+    size_t tamanho;
+    const unsigned char *dados = (const unsigned char*)mapearArquivo(caminho, &tamanho);
+    if (dados == NULL) {
+        return -1;
+    }
+    const unsigned char *p = dados + 28;
+    const unsigned char *fim = dados + tamanho;
+    IdTexto *pistas = NULL;
+    int resultado = 0;
+
+    if (tamanho < 28 || memcmp(dados, MAGICO_SESSAO, 4) != 0) {
+        fprintf(stderr, "%s: não é um arquivo de sessão.\n", caminho);
+        munmap((void*)dados, tamanho);
+        return -1;
+    }
+    uint64_t impressao = lerU32(dados + 4) | ((uint64_t)lerU32(dados + 8) << 32);
+    uint32_t sala = lerU32(dados + 12);
+    uint32_t numPistas = lerU32(dados + 24);
+    if (impressao != impressaoDoCaso(caso) || sala >= caso->mapa.quantidade) {
+        fprintf(stderr, "%s: a sessão é de outro caso.\n", caminho);
+        munmap((void*)dados, tamanho);
+        return -1;
+    }
+    if (numPistas > (size_t)(fim - p) / 2) {
+        resultado = -1;
+    } else {
+        pistas = (IdTexto*)calloc((size_t)numPistas + 1, sizeof(IdTexto));
+        if (pistas == NULL) {
+            perror("Erro de alocação de memória para as pistas da sessão");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (uint32_t i = 0; i < numPistas && resultado == 0; i++) {
+        if (fim - p < 2) { resultado = -1; break; }
+        uint16_t tamPista = lerU16(p);
+        p += 2;
+        if (fim - p < tamPista) { resultado = -1; break; }
+        pistas[i] = internarTextoN((const char*)p, tamPista);
+        p += tamPista;
+        // montarPistasOrdenadas exige a ordem estrita da árvore, que salvarSessao gravou
+        if (pistas[i] == TEXTO_VAZIO || (i > 0 && !chaveVemAntes(chaveDoId(pistas[i - 1]), chaveDoId(pistas[i])))) {
+            resultado = -1;
+        }
+    }
+
+    if (resultado == 0) {
+        iniciarInvestigacao(investigacao, arena, &caso->associacoes);
+        investigacao->pistas = montarPistasOrdenadas(arena, pistas, numPistas);
+        for (uint32_t i = 0; i < numPistas; i++) {
+            anotarEvidencia(investigacao, &caso->associacoes, pistas[i]);
+        }
+        investigacao->sala = sala;
+        investigacao->explorada = (lerU32(dados + 16) & 1u) != 0;
+        investigacao->pistasRepetidas = lerU32(dados + 20);
+    } else {
+        fprintf(stderr, "%s: arquivo de sessão truncado ou inválido.\n", caminho);
+    }
+    free(pistas);
+    munmap((void*)dados, tamanho);
+    return resultado;
+}
+
+// Função para liberar a memória da Tabela Hash
+static void liberarHash(TabelaHash *tabela) {
+    for (unsigned int i = 0; i < tabela->numSuspeitos; i++) {
+        free(tabela->pistasDoSuspeito[i].pistas);
+    }
+    free(tabela->itens);
+    free(tabela->suspeitos);
+    free(tabela->pistasDoSuspeito);
+    free(tabela->suspeitoDoTexto);
+    free(tabela->pilotos);
+    free(tabela->filtro);
+    tabela->itens = NULL;
+    tabela->capacidade = 0;
+    tabela->quantidade = 0;
+    tabela->suspeitos = NULL;
+    tabela->pistasDoSuspeito = NULL;
+    tabela->numSuspeitos = 0;
+    tabela->capacidadeSuspeitos = 0;
+    tabela->suspeitoDoTexto = NULL;
+    tabela->tamanhoSuspeitoDoTexto = 0;
+    tabela->pilotos = NULL;
+    tabela->numBaldes = 0;
+    tabela->filtro = NULL;
+    tabela->blocosFiltro = 0;
+}
+
+// Prepara um caso vazio (mansão e pistas ainda não montadas)
+static void inicializarCaso(Caso *caso) {
+    caso->arena.atual = NULL;
+    caso->arenaMontagem.atual = NULL;
+    caso->mansao = NULL;
+    caso->mapa.salas = NULL;
+    caso->mapa.quantidade = 0;
+    memset(&caso->mapa.rotas, 0, sizeof(IndiceRotas));
+    memset(&caso->mapa.indice, 0, sizeof(IndiceSalas));
+    inicializarHash(&caso->associacoes);
+}
+
+/**
+ * Libera o caso inteiro numa única chamada: os blocos da arena levam juntos
+ * todos os nós das pistas e a mansão congelada é um único vetor (mais os dos
+ * seus índices).
+ */
+static void liberarCaso(Caso *caso) {
+    liberarArena(&caso->arena);
+    liberarArena(&caso->arenaMontagem);
+    free(caso->mapa.salas);
+    caso->mapa.salas = NULL;
+    caso->mapa.quantidade = 0;
+    liberarRotas(&caso->mapa.rotas);
+    liberarIndiceSalas(&caso->mapa.indice);
+    liberarHash(&caso->associacoes);
+    caso->mansao = NULL;
+}
+
+// --- 6. SERVIDOR ---
+
+/*
+ * Protocolo: cada conexão ao socket é um roteiro (o mesmo formato de --roteiro).
+ * O cliente envia os comandos, uma linha cada; o servidor responde uma linha
+ * VEREDITO por sessão assim que ela termina. A conexão acaba quando o cliente
+ * fecha a escrita. Ex.: socat - UNIX-CONNECT:/tmp/detective.sock < roteiro.txt
+ *
+ * O caso é congelado antes de os trabalhadores nascerem e depois disso ninguém
+ * escreve nele: mansão, associações e textos internados são lidos sem trava.
+ * Cada trabalhador tem a sua arena, reaproveitada de sessão em sessão.
+ */
+
+// Anota (ou apaga, com -1) a conexão de um trabalhador; no encerramento, recusa a nova
+// conexão e retorna 0
+static int registrarCliente(Servidor *servidor, unsigned int indice, int conexao) {
+    pthread_mutex_lock(&servidor->travaClientes);
+    int aceita = conexao < 0 || !atomic_load(&servidor->encerrando);
+    servidor->clientes[indice] = aceita ? conexao : -1;
+    pthread_mutex_unlock(&servidor->travaClientes);
+    return aceita;
+}
+
+/**
+ * Atende uma conexão do começo ao fim, com a arena do trabalhador. A conexão
+ * sai de clientes[] antes de ser fechada, para o encerramento nunca mexer num
+ * descritor já reaproveitado.
+ */
+static void atenderConexao(Servidor *servidor, unsigned int indice, Arena *arena, int conexao) {
+    int copia = dup(conexao);
+    FILE *entrada = fdopen(conexao, "r");
+    FILE *saida = copia >= 0 ? fdopen(copia, "w") : NULL;
+    if (entrada == NULL || saida == NULL) {
+        perror("fdopen");
+        registrarCliente(servidor, indice, -1);
+        if (entrada != NULL) fclose(entrada); else close(conexao);
+        if (saida != NULL) fclose(saida); else if (copia >= 0) close(copia);
+        return;
+    }
+    // Uma linha por sessão: cada VEREDITO vai para o cliente assim que é escrito
+    setvbuf(saida, NULL, _IOLBF, 0);
+
+    FonteComandos fonte = { entrada, 0, 0 };
+    unsigned long sessoes = reproduzirRoteiro(servidor->caso, arena, &fonte, saida, NULL);
+    registrarCliente(servidor, indice, -1);
+    fclose(saida);
+    fclose(entrada);
+
+    atomic_fetch_add_explicit(&servidor->conexoes, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&servidor->sessoes, sessoes, memory_order_relaxed);
+}
+
+// Laço de um trabalhador: aceita conexões até o servidor encerrar
+static void* trabalhadorServidor(void *argumento) {
+    Servidor *servidor = ((TrabalhadorServidor*)argumento)->servidor;
+    unsigned int indice = ((TrabalhadorServidor*)argumento)->indice;
+    Arena arena = { NULL };
+
+    while (1) {
+        int conexao = accept(servidor->socketEscuta, NULL, NULL);
+        if (conexao < 0) {
+            if (atomic_load(&servidor->encerrando)) {
+                break;
+            }
+            if (errno != EINTR && errno != ECONNABORTED) {
+                perror("accept");
+            }
+            continue;
+        }
+        if (!registrarCliente(servidor, indice, conexao)) {
+            close(conexao); // Chegou depois do pedido de parada
+            break;
+        }
+        atenderConexao(servidor, indice, &arena, conexao);
+    }
+
+    liberarArena(&arena);
+    recolherContadoresFiltro();
+    return NULL;
+}
+
+/**
+ * Serve o caso (já congelado) no socket Unix 'caminho' com 'trabalhadores' threads.
+ * Roda até receber SIGINT ou SIGTERM; então encerra a leitura das conexões em
+ * andamento (as sessões já completas ainda recebem o VEREDITO) e espera os
+ * trabalhadores. A máscara de sinais e o tratamento de SIGPIPE são restaurados na saída.
+ * Os histogramas e o trace da medição não têm trava: com a medição ligada o
+ * servidor não roda.
+ * Retorna 0 em caso de sucesso ou -1 se o socket não pôde ser aberto ou a
+ * medição estiver ligada.
+ */
+int executarServidor(Caso *caso, const char *caminho, unsigned int trabalhadores) {
+    if (medicao.ativa) {
+        fprintf(stderr, "O modo servidor não pode rodar com a medição ligada (chame encerrarMedicao antes).\n");
+        return -1;
+    }
+
+    struct sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+        fprintf(stderr, "%s: caminho longo demais para um socket.\n", caminho);
+        return -1;
+    }
+    strcpy(endereco.sun_path, caminho);
+
+    // Um socket esquecido por uma execução anterior impediria o bind
+    struct stat info;
+    if (stat(caminho, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(caminho);
+    }
+
+    Servidor servidor;
+    servidor.caso = caso;
+    atomic_init(&servidor.encerrando, 0);
+    atomic_init(&servidor.conexoes, 0);
+    atomic_init(&servidor.sessoes, 0);
+    for (unsigned int i = 0; i < MAXIMO_TRABALHADORES; i++) {
+        servidor.clientes[i] = -1;
+    }
+    servidor.socketEscuta = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (servidor.socketEscuta < 0 ||
+        bind(servidor.socketEscuta, (struct sockaddr*)&endereco, sizeof(endereco)) != 0 ||
+        listen(servidor.socketEscuta, SOMAXCONN) != 0) {
+        perror(caminho);
+        if (servidor.socketEscuta >= 0) close(servidor.socketEscuta);
+        return -1;
+    }
+
+    pthread_mutex_init(&servidor.travaClientes, NULL);
+
+    // Os sinais de parada ficam bloqueados em todas as threads; só a principal os espera
+    sigset_t sinais, mascaraAnterior;
+    sigemptyset(&sinais);
+    sigaddset(&sinais, SIGINT);
+    sigaddset(&sinais, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sinais, &mascaraAnterior);
+    // Cliente que fecha cedo vira erro de escrita, não morte do processo
+    struct sigaction ignorarPipe, pipeAnterior;
+    memset(&ignorarPipe, 0, sizeof(ignorarPipe));
+    ignorarPipe.sa_handler = SIG_IGN;
+    sigemptyset(&ignorarPipe.sa_mask);
+    sigaction(SIGPIPE, &ignorarPipe, &pipeAnterior);
+
+    if (trabalhadores < 1) trabalhadores = 1;
+    if (trabalhadores > MAXIMO_TRABALHADORES) trabalhadores = MAXIMO_TRABALHADORES;
+    pthread_t threads[MAXIMO_TRABALHADORES];
+    TrabalhadorServidor argumentos[MAXIMO_TRABALHADORES];
+    unsigned int iniciadas = 0;
+    for (; iniciadas < trabalhadores; iniciadas++) {
+        argumentos[iniciadas] = (TrabalhadorServidor){ &servidor, iniciadas };
+        if (pthread_create(&threads[iniciadas], NULL, trabalhadorServidor, &argumentos[iniciadas]) != 0) {
+            perror("pthread_create");
+            break;
+        }
+    }
+    fprintf(stderr, "Servidor ouvindo em %s com %u trabalhador(es). Ctrl+C encerra.\n", caminho, iniciadas);
+
+    if (iniciadas > 0) {
+        int sinal;
+        sigwait(&sinais, &sinal);
+    }
+
+    // shutdown acorda os trabalhadores parados em accept e, nas conexões abertas,
+    // dá fim de arquivo a quem espera um cliente que não fecha a escrita
+    pthread_mutex_lock(&servidor.travaClientes);
+    atomic_store(&servidor.encerrando, 1);
+    for (unsigned int i = 0; i < iniciadas; i++) {
+        if (servidor.clientes[i] >= 0) {
+            shutdown(servidor.clientes[i], SHUT_RD);
+        }
+    }
+    pthread_mutex_unlock(&servidor.travaClientes);
+    shutdown(servidor.socketEscuta, SHUT_RDWR);
+    for (unsigned int i = 0; i < iniciadas; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    close(servidor.socketEscuta);
+    unlink(caminho);
+    pthread_mutex_destroy(&servidor.travaClientes);
+    sigaction(SIGPIPE, &pipeAnterior, NULL);
+    pthread_sigmask(SIG_SETMASK, &mascaraAnterior, NULL);
+
+    fprintf(stderr, "Servidor encerrado: %lu sessão(ões) em %lu conexão(ões).\n",
+            atomic_load(&servidor.sessoes), atomic_load(&servidor.conexoes));
+    return 0;
+}
+
+// --- 7. INTERFACE DA BIBLIOTECA (detective.h) ---
+
+// Investigação aberta por abrirInvestigacao: carrega a própria arena, então
+// várias podem correr ao mesmo tempo sobre o mesmo caso congelado
+typedef struct InvestigacaoAberta {
+    Investigacao investigacao; // Primeiro campo: o ponteiro entregue ao chamador aponta para ele
+    Arena arena;
+} InvestigacaoAberta;
+
+void narrar(const char *formato, ...) {
+    if (nivelLog >= NIVEL_INFO) {
+        va_list argumentos;
+        va_start(argumentos, formato);
+        vprintf(formato, argumentos);
+        va_end(argumentos);
+    }
+}
+
+Caso* criarCaso(void) {
+    Caso *caso = (Caso*)malloc(sizeof(Caso));
+    if (caso == NULL) {
+        perror("Erro de alocação de memória para Caso");
+        exit(EXIT_FAILURE);
+    }
+    inicializarCaso(caso);
+    return caso;
+}
+
+void destruirCaso(Caso *caso) {
+    liberarCaso(caso);
+    free(caso);
+}
+
+int gerarHashPerfeito(Caso *caso, const char *caminho) {
+    if (gerarPerfeita(&caso->associacoes) != 0) {
+        fprintf(stderr, "%s: não foi possível gerar o hash perfeito das associações.\n", caminho);
+        return -1;
+    }
+    return salvarPerfeita(&caso->associacoes, caminho);
+}
+
+int usarHashPerfeito(Caso *caso, const char *caminho) {
+    return carregarPerfeita(&caso->associacoes, caminho);
+}
+
+void ativarFiltro(Caso *caso, double taxa) {
+    construirFiltro(&caso->associacoes, taxa);
+}
+
+unsigned int associacoesDoCaso(const Caso *caso) {
+    return caso->associacoes.quantidade;
+}
+
+const char* suspeitoDaPista(Caso *caso, const char *pista) {
+    return encontrarSuspeito(&caso->associacoes, pista);
+}
+
+void imprimirRelatorioCaso(FILE *saida, const Caso *caso) {
+    RelatorioHash relatorio;
+    relatorioHash(&caso->associacoes, &relatorio);
+    imprimirRelatorioHash(saida, "", "Associações", &relatorio);
+    relatorioInternos(&relatorio);
+    imprimirRelatorioHash(saida, "", "Textos internados", &relatorio);
+}
+
+// Põe o jogador na sala e coleta a pista dela (sem narração)
+static void visitarSala(Caso *caso, Investigacao *investigacao, uint32_t sala) {
+    investigacao->sala = sala;
+    if (caso->mapa.salas[sala].pista != TEXTO_VAZIO) {
+        coletarPista(investigacao, &caso->associacoes, caso->mapa.salas[sala].pista);
+    }
+}
+
+Investigacao* abrirInvestigacao(Caso *caso) {
+    InvestigacaoAberta *aberta = (InvestigacaoAberta*)malloc(sizeof(InvestigacaoAberta));
+    if (aberta == NULL) {
+        perror("Erro de alocação de memória para Investigacao");
+        exit(EXIT_FAILURE);
+    }
+    aberta->arena.atual = NULL;
+    iniciarInvestigacao(&aberta->investigacao, &aberta->arena, &caso->associacoes);
+    if (caso->mapa.quantidade > 0) {
+        visitarSala(caso, &aberta->investigacao, 0);
+    }
+    return &aberta->investigacao;
+}
+
+const char* salaDaInvestigacao(const Caso *caso, const Investigacao *investigacao) {
+    if (investigacao->sala >= caso->mapa.quantidade) {
+        return NULL;
+    }
+    return textoDoId(caso->mapa.salas[investigacao->sala].nome);
+}
+
+int moverInvestigacao(Caso *caso, Investigacao *investigacao, char direcao) {
+    if (investigacao->sala >= caso->mapa.quantidade) {
+        return 0;
+    }
+    const SalaCompacta *atual = &caso->mapa.salas[investigacao->sala];
+    direcao = (char)tolower((unsigned char)direcao);
+    uint32_t destino = direcao == 'e' ? atual->esquerda : direcao == 'd' ? atual->direita
+                     : direcao == 'v' ? caso->mapa.rotas.pais[investigacao->sala] : SEM_SALA;
+    if (destino == SEM_SALA) {
+        return 0;
+    }
+    visitarSala(caso, investigacao, destino);
+    return 1;
+}
+
+int irParaSala(Caso *caso, Investigacao *investigacao, const char *sala) {
+    uint32_t destino = procurarSala(&caso->mapa, sala);
+    if (destino == SEM_SALA) {
+        return 0;
+    }
+    visitarSala(caso, investigacao, destino);
+    return 1;
+}
+
+unsigned int salasComPista(const Caso *caso, const char *pista, const char **salas, unsigned int maximo) {
+    const uint32_t *encontradas;
+    uint32_t quantas = procurarPista(&caso->mapa, pista, &encontradas);
+    for (uint32_t i = 0; i < quantas && i < maximo; i++) {
+        salas[i] = textoDoId(caso->mapa.salas[encontradas[i]].nome);
+    }
+    return quantas;
+}
+
+long rotaEntreSalas(const Caso *caso, const char *origem, const char *destino, char *passos, size_t capacidade) {
+    uint32_t de = procurarSala(&caso->mapa, origem);
+    uint32_t ate = procurarSala(&caso->mapa, destino);
+    if (de == SEM_SALA || ate == SEM_SALA) {
+        return -1;
+    }
+    return (long)rotaNaMansao(&caso->mapa, de, ate, passos, capacidade);
+}
+
+int julgarAcusacao(Caso *caso, const Investigacao *investigacao, const char *acusado, unsigned int *pistas) {
+    *pistas = evidenciasContra(investigacao, &caso->associacoes, buscarChave(acusado));
+    return *pistas >= PISTAS_PARA_CONDENAR;
+}
+
+void fecharInvestigacao(Investigacao *investigacao) {
+    InvestigacaoAberta *aberta = (InvestigacaoAberta*)investigacao;
+    liberarArena(&aberta->arena);
+    free(aberta);
+}
+
+unsigned long executarRoteiro(Caso *caso, FILE *entrada, FILE *saida, Estatisticas *estatisticas) {
+    FonteComandos fonte = { entrada, 0, 0 };
+    return reproduzirRoteiro(caso, &caso->arena, &fonte, saida, estatisticas);
+}
+
+int jogarInterativo(Caso *caso, FILE *entrada, const char *arquivoSessao, Estatisticas *estatisticas) {
+    FonteComandos fonte = { entrada, 1, 0 };
+    int resultado = 0;
+
+    // --- Início do Jogo (ou retomada de uma investigação guardada) ---
+    Investigacao investigacao;
+    int retomada = 0;
+    if (arquivoSessao != NULL && access(arquivoSessao, F_OK) == 0) {
+        if (carregarSessao(caso, &caso->arena, &investigacao, arquivoSessao) != 0) {
+            return -1;
+        }
+        SAIDA("\n> Investigação retomada de '%s'.\n", arquivoSessao);
+        retomada = 1;
+    } else {
+        iniciarInvestigacao(&investigacao, &caso->arena, &caso->associacoes);
+    }
+
+    // Exploração da mansão (navegação na mansão congelada)
+    int pausada = 0;
+    if (!investigacao.explorada) {
+        SAIDA("\n================ INÍCIO DA EXPLORAÇÃO ================\n");
+        pausada = explorarSalas(&caso->mapa, &caso->associacoes, &investigacao, &fonte, !retomada);
+        while (pausada && arquivoSessao == NULL) {
+            SAIDA(" Sem --sessao não há onde guardar a investigação; a exploração continua.\n");
+            pausada = explorarSalas(&caso->mapa, &caso->associacoes, &investigacao, &fonte, 0);
+        }
+    }
+
+    // Conduz a fase de julgamento (contadores de evidência da investigação)
+    Veredito veredito;
+    int acusou = !pausada && verificarSuspeitoFinal(&investigacao, &caso->associacoes, &fonte, &veredito);
+    if (arquivoSessao != NULL) {
+        if (acusou) {
+            remove(arquivoSessao); // Caso encerrado: não há mais o que retomar
+        } else if (salvarSessao(caso, &investigacao, arquivoSessao) == 0) {
+            SAIDA("\n> Investigação guardada em '%s'.\n", arquivoSessao);
+        } else {
+            resultado = -1;
+        }
+    }
+    if (estatisticas != NULL) {
+        acumularInvestigacao(estatisticas, &investigacao);
+    }
+    return resultado;
+}
+
+Estatisticas* criarEstatisticas(void) {
+    Estatisticas *estatisticas = (Estatisticas*)malloc(sizeof(Estatisticas));
+    if (estatisticas == NULL) {
+        perror("Erro de alocação de memória para Estatisticas");
+        exit(EXIT_FAILURE);
+    }
+    iniciarEstatisticas(estatisticas);
+    return estatisticas;
+}
+
+void destruirEstatisticas(Estatisticas *estatisticas) {
+    free(estatisticas);
+}
@@ -0,0 +1,203 @@
+// Detective Quest - motor do jogo (libdetective)
+// Mansão, pistas coletadas, associações pista -> suspeito e veredito, atrás de
+// ponteiros opacos. Os programas que embutem o motor incluem só este cabeçalho e
+// ligam com libdetective.a (ver o Makefile: make, make release, make pgo).
+//
+// Uso típico:
+//   Caso *caso = criarCaso();
+//   carregarCaso(caso, "casos/mansao_classica.txt");  // ou montarCasoPadrao(caso)
+//   congelarCaso(caso);
+//   Investigacao *investigacao = abrirInvestigacao(caso);
+//   moverInvestigacao(caso, investigacao, 'd');
+//   unsigned int pistas;
+//   int sustentada = julgarAcusacao(caso, investigacao, "Cecilia", &pistas);
+//   fecharInvestigacao(investigacao);
+//   destruirCaso(caso);
+//   liberarInternos();
+//
+// Depois de congelado, o caso só é lido: várias threads podem abrir investigações
+// sobre ele ao mesmo tempo. Montar ou alterar um caso não é seguro entre threads,
+// nem jogar em várias threads com a medição (ativarMedicao) ligada.
+
+#ifndef DETECTIVE_H
+#define DETECTIVE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Níveis de log (configurarLog)
+#define NIVEL_SILENCIOSO 0 // Nenhuma narração (padrão do modo roteiro)
+#define NIVEL_INFO 1       // Narração do jogo (padrão do modo interativo)
+#define NIVEL_DEPURACAO 2  // Também cada sala criada e cada associação inserida
+
+#define MAXIMO_TRABALHADORES 256 // Limite de threads do modo servidor e da redução paralela
+
+// Tipos opacos: o conteúdo só é conhecido dentro da biblioteca
+typedef struct Caso Caso;                 // Mansão e associações de um caso
+typedef struct Investigacao Investigacao; // Pistas coletadas por um jogador e contadores de evidência
+typedef struct Estatisticas Estatisticas; // Números de uma execução (--stats)
+
+// --- Configuração global ---
+
+/**
+ * Converte o nome de um nível de log ("silencioso", "info" ou "depuracao").
+ * Retorna o nível, ou -1 se o nome for desconhecido.
+ */
+int nivelDoNome(const char *nome);
+
+// Define o nível de log e troca o buffer de stdout por um buffer grande
+void configurarLog(int nivel);
+
+// Escreve em stdout, como printf, se o nível de log for pelo menos NIVEL_INFO
+void narrar(const char *formato, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Escolhe a função de hash pelo nome: "rapido", "fnv1a" ou "polinomial".
+ * Só vale antes de carregar o primeiro caso. Retorna 1 se a troca foi feita.
+ */
+int selecionarHash(const char *nome);
+
+/**
+ * Liga os cronômetros das fases; com comTrace, guarda também cada intervalo.
+ * A medição é global e sem trava: só vale com uma thread jogando, e
+ * executarServidor recusa rodar enquanto ela estiver ligada.
+ */
+void ativarMedicao(int comTrace);
+
+// Mostra p50/p99/máximo de cada fase medida
+void imprimirLatencias(FILE *saida);
+
+// Grava o trace (formato Chrome/Perfetto). Retorna 0 ou -1 em caso de erro.
+int salvarTrace(const char *caminho);
+
+// Desliga a medição e libera o trace
+void encerrarMedicao(void);
+
+// Libera os textos internados, compartilhados por todos os casos (chamar no fim)
+void liberarInternos(void);
+
+// --- Caso ---
+
+// Cria um caso vazio
+Caso* criarCaso(void);
+
+/**
+ * Carrega mansão e associações de um arquivo de caso (texto ou binário .dqc).
+ * Retorna 0 em caso de sucesso ou -1 (com a mensagem em stderr).
+ */
+int carregarCaso(Caso *caso, const char *caminho);
+
+// Monta o caso clássico embutido no motor
+void montarCasoPadrao(Caso *caso);
+
+// Encerra a montagem: a partir daqui a mansão não muda e o caso pode ser jogado
+void congelarCaso(Caso *caso);
+
+// Grava o caso (congelado) no formato binário. Retorna 0 ou -1.
+int salvarCasoBinario(Caso *caso, const char *caminho);
+
+// Gera o hash perfeito mínimo das associações e o grava em 'caminho'. Retorna 0 ou -1.
+int gerarHashPerfeito(Caso *caso, const char *caminho);
+
+// Passa a consultar as associações pelo hash perfeito gravado antes. Retorna 0 ou -1.
+int usarHashPerfeito(Caso *caso, const char *caminho);
+
+// Põe um filtro de Bloom com essa taxa de falsos positivos na frente das associações
+void ativarFiltro(Caso *caso, double taxa);
+
+// Número de associações pista -> suspeito do caso
+unsigned int associacoesDoCaso(const Caso *caso);
+
+// Suspeito associado à pista (qualquer grafia), ou NULL se não houver
+const char* suspeitoDaPista(Caso *caso, const char *pista);
+
+// Mostra a distribuição das tabelas hash do caso (--relatorio-hash)
+void imprimirRelatorioCaso(FILE *saida, const Caso *caso);
+
+// Libera o caso inteiro
+void destruirCaso(Caso *caso);
+
+// --- Investigação passo a passo ---
+
+// Começa uma investigação no Hall (com a pista dele já coletada); tem memória própria
+Investigacao* abrirInvestigacao(Caso *caso);
+
+// Nome da sala onde o jogador está
+const char* salaDaInvestigacao(const Caso *caso, const Investigacao *investigacao);
+
+/**
+ * Anda para a esquerda ('e'), para a direita ('d') ou volta para a sala de cima
+ * ('v') e coleta a pista da sala. Retorna 1 se andou ou 0 se não há saída nessa direção.
+ */
+int moverInvestigacao(Caso *caso, Investigacao *investigacao, char direcao);
+
+// Leva o jogador direto à sala com esse nome (qualquer grafia) e coleta a pista dela.
+// Retorna 1 se a sala existe ou 0 caso contrário.
+int irParaSala(Caso *caso, Investigacao *investigacao, const char *sala);
+
+/**
+ * Salas onde está a pista (qualquer grafia), da mais próxima do Hall para a mais
+ * distante: 'salas' recebe os nomes de até 'maximo' delas. Custa O(1) mais a resposta.
+ * Retorna quantas salas têm a pista.
+ */
+unsigned int salasComPista(const Caso *caso, const char *pista, const char **salas, unsigned int maximo);
+
+/**
+ * Caminho mais curto entre duas salas (pelo nome, qualquer grafia): 'passos'
+ * recebe os movimentos ('v' volta para a sala de cima, 'e'/'d' descem) como
+ * snprintf, no máximo capacidade - 1 e um '\0' ('passos' pode ser NULL com
+ * capacidade 0). O tamanho sai em O(1); os passos custam o tamanho da rota.
+ * Retorna o número de movimentos, ou -1 se alguma das salas não existir.
+ */
+long rotaEntreSalas(const Caso *caso, const char *origem, const char *destino, char *passos, size_t capacidade);
+
+/**
+ * Julga a acusação: 'pistas' recebe quantas pistas coletadas apontam para o
+ * acusado. Retorna 1 se elas bastam para condená-lo ou 0 caso contrário.
+ */
+int julgarAcusacao(Caso *caso, const Investigacao *investigacao, const char *acusado, unsigned int *pistas);
+
+// Libera a investigação
+void fecharInvestigacao(Investigacao *investigacao);
+
+// --- Modos de jogo ---
+
+/**
+ * Reproduz as sessões de um roteiro (comandos em 'entrada', uma linha cada) e
+ * escreve uma linha VEREDITO por sessão em 'saida'. Estatisticas pode ser NULL.
+ * Retorna o número de sessões reproduzidas.
+ */
+unsigned long executarRoteiro(Caso *caso, FILE *entrada, FILE *saida, Estatisticas *estatisticas);
+
+/**
+ * Jogo interativo com os comandos de 'entrada'. Com arquivoSessao, retoma a
+ * investigação guardada nele (se houver) e a guarda de novo se o jogador pausar
+ * ou a entrada acabar antes da acusação. Estatisticas pode ser NULL.
+ * Retorna 0 ou -1 se a sessão não pôde ser lida ou gravada.
+ */
+int jogarInterativo(Caso *caso, FILE *entrada, const char *arquivoSessao, Estatisticas *estatisticas);
+
+/**
+ * Visita todas as salas, conta as evidências com 'trabalhadores' threads e
+ * confere com a contagem sequencial. Retorna 0 se bateram ou -1.
+ */
+int executarVarredura(Caso *caso, unsigned int trabalhadores);
+
+/**
+ * Atende roteiros num socket Unix até SIGINT/SIGTERM.
+ * Retorna 0 ou -1 se o socket não pôde ser aberto ou a medição estiver ligada.
+ */
+int executarServidor(Caso *caso, const char *caminho, unsigned int trabalhadores);
+
+// --- Estatísticas ---
+
+Estatisticas* criarEstatisticas(void);
+
+// Mede as estruturas do caso (mansão, tabelas, memória) e soma o filtro de Bloom
+void medirCaso(const Caso *caso, Estatisticas *estatisticas);
+
+void imprimirEstatisticas(FILE *saida, const Estatisticas *estatisticas);
+
+void destruirEstatisticas(Estatisticas *estatisticas);
+
+#endif // DETECTIVE_H